@@ -4,22 +4,30 @@
 #include "AICharacter.h"
 #include "MyAIController.h"
 #include "BehaviorTree/BehaviorTree.h"
-#include "Perception/PawnSensingComponent.h"
+#include "ProjectilePoolSubsystem.h"
+#include "ProjectileSimulationSubsystem.h"
+#include "HitscanSubsystem.h"
+#include "GunshotAudioSubsystem.h"
+#include "AIFireControlSubsystem.h"
+#include "PawnPerceptionSubsystem.h"
+#include "AISignificanceSubsystem.h"
+#include "FlowFieldSubsystem.h"
+#include "AIDecisionSubsystem.h"
+#include "AnimationBudgetSubsystem.h"
+#include "EnemyMovementComponent.h"
+#include "AISquadSubsystem.h"
+#include "RagdollSubsystem.h"
+#include "EnemyPoolSubsystem.h"
+#include "BrainComponent.h"
+#include "Components/CapsuleComponent.h"
 
 
 // Sets default values
-AAICharacter::AAICharacter()
+AAICharacter::AAICharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UEnemyMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
- 	// Set this character to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
-
-
-	//Initialise pawn sensing component
-
-	PawnSensingComp = CreateDefaultSubobject<UPawnSensingComponent>(TEXT("PawnSensingComp"));
-
-	//SetPeripheral vision to 90 **WILL MOST LIKELY CHANGE FOR CONE VISION
-	PawnSensingComp->SetPeripheralVisionAngle(90.f);
+ 	// Firing is driven by the AI fire control, nothing else needs the actor to tick
+	PrimaryActorTick.bCanEverTick = false;
 
 	MuzzleLocation = CreateDefaultSubobject<USceneComponent>(TEXT("MuzzleLocation"));
 	MuzzleLocation->SetupAttachment(RootComponent);
@@ -32,19 +40,188 @@ void AAICharacter::BeginPlay()
 	Super::BeginPlay();
 
 	//Register function that is going to fire when character sees pawn
+	OnSeePawn.AddDynamic(this, &AAICharacter::OnSeePlayer);
+
+	//Pooled enemies join the AI systems when the pool wakes them up
+	if (!OwningPool.IsValid())
+	{
+		JoinAISystems();
+	}
+
+	EquipWeapon(INDEX_NONE);
+}
+
+void AAICharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	LeaveAISystems();
+	Super::EndPlay(EndPlayReason);
+}
+
+void AAICharacter::JoinAISystems()
+{
+	if (UPawnPerceptionSubsystem* Perception = GetWorld()->GetSubsystem<UPawnPerceptionSubsystem>())
+	{
+		Perception->RegisterPawn(this, false);
+		Perception->RegisterObserver(this);
+	}
+	if (UAISignificanceSubsystem* Significance = GetWorld()->GetSubsystem<UAISignificanceSubsystem>())
+	{
+		Significance->RegisterEnemy(this);
+	}
+	if (UAISquadSubsystem* Squads = GetWorld()->GetSubsystem<UAISquadSubsystem>())
+	{
+		Squads->JoinSquad(this);
+	}
+	if (UAIDecisionSubsystem* Decisions = GetWorld()->GetSubsystem<UAIDecisionSubsystem>())
+	{
+		Decisions->RegisterEnemy(this);
+	}
+	if (UAnimationBudgetSubsystem* AnimBudget = GetWorld()->GetSubsystem<UAnimationBudgetSubsystem>())
+	{
+		AnimBudget->RegisterEnemy(this);
+	}
+	if (bUseFlowField)
+	{
+		if (UFlowFieldSubsystem* FlowField = GetWorld()->GetSubsystem<UFlowFieldSubsystem>())
+		{
+			FlowField->RegisterFollower(this);
+		}
+	}
+}
+
+void AAICharacter::LeaveAISystems()
+{
+	if (UPawnPerceptionSubsystem* Perception = GetWorld()->GetSubsystem<UPawnPerceptionSubsystem>())
+	{
+		Perception->UnregisterObserver(this);
+		Perception->UnregisterPawn(this);
+	}
+	if (UAIFireControlSubsystem* FireControl = GetWorld()->GetSubsystem<UAIFireControlSubsystem>())
+	{
+		FireControl->Disengage(this);
+	}
+	if (UAISignificanceSubsystem* Significance = GetWorld()->GetSubsystem<UAISignificanceSubsystem>())
+	{
+		Significance->UnregisterEnemy(this);
+	}
+	if (UFlowFieldSubsystem* FlowField = GetWorld()->GetSubsystem<UFlowFieldSubsystem>())
+	{
+		FlowField->UnregisterFollower(this);
+	}
+	if (UAISquadSubsystem* Squads = GetWorld()->GetSubsystem<UAISquadSubsystem>())
+	{
+		Squads->LeaveSquad(this);
+	}
+	if (UAIDecisionSubsystem* Decisions = GetWorld()->GetSubsystem<UAIDecisionSubsystem>())
+	{
+		Decisions->UnregisterEnemy(this);
+	}
+	if (UAnimationBudgetSubsystem* AnimBudget = GetWorld()->GetSubsystem<UAnimationBudgetSubsystem>())
+	{
+		AnimBudget->UnregisterEnemy(this);
+	}
+}
+
+void AAICharacter::EquipWeapon(int32 Weapon)
+{
+	const AAICharacter* Defaults = GetClass()->GetDefaultObject<AAICharacter>();
+	CurrentWeapon = Weapons.IsValidIndex(Weapon) ? Weapon : INDEX_NONE;
+	if (Weapons.IsValidIndex(Weapon))
+	{
+		const FWeaponDefinition& Definition = Weapons[Weapon];
+		CurrentProjectileClass = Definition.ProjectileClass ? Definition.ProjectileClass.Get() : Defaults->CurrentProjectileClass;
+		ShootSound = Definition.ShootSound ? Definition.ShootSound : Defaults->ShootSound;
+		FireInterval = Definition.ShootSpeed > 0.f ? Definition.ShootSpeed : Defaults->FireInterval;
+		bHitscan = Definition.bHitscan;
+		bSimulateProjectiles = Definition.bSimulateProjectiles;
+	}
+	else if (HasActorBegunPlay())
+	{
+		//A recycled enemy may still hold the last spawner's weapon
+		CurrentProjectileClass = Defaults->CurrentProjectileClass;
+		ShootSound = Defaults->ShootSound;
+		FireInterval = Defaults->FireInterval;
+		bHitscan = Defaults->bHitscan;
+		bSimulateProjectiles = Defaults->bSimulateProjectiles;
+	}
+
+	//Enemies share one pool per bullet class, so this only spawns for the first enemy of a type
+	if (UProjectilePoolSubsystem* Pool = GetWorld()->GetSubsystem<UProjectilePoolSubsystem>())
+	{
+		Pool->PrewarmPool(CurrentProjectileClass);
+	}
 
-	if (PawnSensingComp) {
-		PawnSensingComp->OnSeePawn.AddDynamic(this, &AAICharacter::OnSeePlayer);
+	ProjectileSpeed = 0.f;
+	if (!bHitscan)
+	{
+		float Damage, LifeTime;
+		UProjectileSimulationSubsystem::GetBulletStats(CurrentProjectileClass, ProjectileSpeed, Damage, LifeTime);
 	}
-	
 }
 
-// Called every frame
-void AAICharacter::Tick(float DeltaTime)
+void AAICharacter::InjectStats(int32 Health, int32 Weapon)
 {
-	Super::Tick(DeltaTime);
-	GEngine->AddOnScreenDebugMessage(-1, 15.f, FColor::Red, "Fired");
-	Fire();
+	CurrentHealth = Health > 0 ? Health : GetClass()->GetDefaultObject<AAICharacter>()->CurrentHealth;
+	EquipWeapon(Weapon);
+}
+
+void AAICharacter::ActivateEnemy(int32 Health, int32 Weapon)
+{
+	const AAICharacter* Defaults = GetClass()->GetDefaultObject<AAICharacter>();
+	bDormant = false;
+	bDead = false;
+	InjectStats(Health, Weapon);
+
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+	GetCapsuleComponent()->SetCollisionEnabled(Defaults->GetCapsuleComponent()->GetCollisionEnabled());
+	GetMesh()->SetComponentTickEnabled(true);
+	GetCharacterMovement()->SetComponentTickEnabled(true);
+	GetCharacterMovement()->SetDefaultMovementMode();
+
+	JoinAISystems();
+
+	if (AMyAIController* AIController = Cast<AMyAIController>(GetController()))
+	{
+		AIController->SetSeenTarget(nullptr);
+		AIController->ClearFocus(EAIFocusPriority::Gameplay);
+		if (UBrainComponent* Brain = AIController->GetBrainComponent())
+		{
+			Brain->ResumeLogic(TEXT("Pooled"));
+		}
+	}
+}
+
+void AAICharacter::DeactivateEnemy()
+{
+	bDormant = true;
+	LeaveAISystems();
+
+	if (AAIController* AIController = Cast<AAIController>(GetController()))
+	{
+		AIController->StopMovement();
+		if (UBrainComponent* Brain = AIController->GetBrainComponent())
+		{
+			Brain->PauseLogic(TEXT("Pooled"));
+		}
+	}
+
+	//Undo the ragdoll, the mesh goes back on the capsule the way the blueprint set it up
+	const AAICharacter* Defaults = GetClass()->GetDefaultObject<AAICharacter>();
+	USkeletalMeshComponent* MeshComponent = GetMesh();
+	MeshComponent->SetSimulatePhysics(false);
+	MeshComponent->bNoSkeletonUpdate = false;
+	MeshComponent->SetCollisionProfileName(Defaults->GetMesh()->GetCollisionProfileName());
+	MeshComponent->AttachToComponent(GetCapsuleComponent(), FAttachmentTransformRules::SnapToTargetNotIncludingScale);
+	MeshComponent->SetRelativeLocationAndRotation(GetBaseTranslationOffset(), GetBaseRotationOffset());
+	MeshComponent->SetComponentTickEnabled(false);
+
+	GetCharacterMovement()->StopMovementImmediately();
+	GetCharacterMovement()->DisableMovement();
+	GetCharacterMovement()->SetComponentTickEnabled(false);
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+	SetOwner(nullptr);
 }
 
 // Called to bind functionality to input
@@ -55,25 +232,123 @@ void AAICharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputCompone
 
 void AAICharacter::OnSeePlayer(APawn *pawn)
 {
+	//Squads pick one target for all their members
+	if (bInSquad)
+	{
+		if (UAISquadSubsystem* Squads = GetWorld()->GetSubsystem<UAISquadSubsystem>())
+		{
+			Squads->ReportSeen(this, pawn);
+			return;
+		}
+	}
+
+	//The decision update picks targets off the game thread, only fall back to setting it directly without one
+	if (UAIDecisionSubsystem* Decisions = GetWorld()->GetSubsystem<UAIDecisionSubsystem>())
+	{
+		Decisions->ReportSeen(this, pawn);
+		return;
+	}
+
 	AMyAIController* AIController = Cast<AMyAIController>(GetController());
 
 	if (AIController) {
 		GLog->Log("Hello There");
+		AIController->SetSeenTarget(pawn);
 	}
+}
 
-	AIController->SetSeenTarget(pawn);
+FVector AAICharacter::GetMuzzleLocation() const
+{
+	return MuzzleLocation->GetComponentLocation();
 }
 
 
 void AAICharacter::Fire() {
-	UWorld* World = GetWorld();
-	FActorSpawnParameters SpawnParams;
-	SpawnParams.Owner = this;
-	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	if (bHitscan)
+	{
+		if (UHitscanSubsystem* Hitscan = GetWorld()->GetSubsystem<UHitscanSubsystem>())
+		{
+			Hitscan->QueueShot(CurrentProjectileClass, MuzzleLocation->GetComponentLocation(), MuzzleLocation->GetComponentRotation(), this);
+		}
+	}
+	else if (bSimulateProjectiles)
+	{
+		if (UProjectileSimulationSubsystem* Simulation = GetWorld()->GetSubsystem<UProjectileSimulationSubsystem>())
+		{
+			Simulation->SpawnBullet(CurrentProjectileClass, MuzzleLocation->GetComponentLocation(), MuzzleLocation->GetComponentRotation(), this);
+		}
+	}
+	else if (UProjectilePoolSubsystem* Pool = GetWorld()->GetSubsystem<UProjectilePoolSubsystem>())
+	{
+		Pool->AcquireProjectile(CurrentProjectileClass, MuzzleLocation->GetComponentLocation(), MuzzleLocation->GetComponentRotation(), this);
+	}
+
+	if (ShootSound)
+	{
+		if (UGunshotAudioSubsystem* GunshotAudio = GetWorld()->GetSubsystem<UGunshotAudioSubsystem>())
+		{
+			GunshotAudio->PlayGunshot(ShootSound, MuzzleLocation->GetComponentLocation());
+		}
+	}
+}
+
+float AAICharacter::TakeDamage(float DamageAmount, FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser)
+{
+	const float ActualDamage = Super::TakeDamage(DamageAmount, DamageEvent, EventInstigator, DamageCauser);
+	if (ActualDamage > 0.f && CurrentHealth > 0)
+	{
+		CurrentHealth -= FMath::RoundToInt(ActualDamage);
+		if (CurrentHealth <= 0)
+		{
+			Die();
+		}
+	}
+	return ActualDamage;
+}
 
-	UClass* GeneratedBPBullet = Cast<UClass>(CurrentProjectileClass);
-	World->SpawnActor<AActor>(GeneratedBPBullet, MuzzleLocation->GetComponentLocation(), MuzzleLocation->GetComponentRotation(), SpawnParams);
+void AAICharacter::Die()
+{
+	if (bDead)
+	{
+		return;
+	}
+	bDead = true;
 
-	
+	URagdollSubsystem* Ragdolls = GetWorld()->GetSubsystem<URagdollSubsystem>();
+	if (!Ragdolls)
+	{
+		if (UEnemyPoolSubsystem* Pool = OwningPool.Get())
+		{
+			Pool->ReleaseEnemy(this);
+		}
+		else
+		{
+			Destroy();
+		}
+		return;
+	}
+
+	//Stop being an enemy straight away, the body stays around as a corpse until the ragdoll manager removes it.
+	//Pooled enemies keep their controller, paused, for the next time they are handed out
+	LeaveAISystems();
+	if (OwningPool.IsValid())
+	{
+		if (AAIController* AIController = Cast<AAIController>(GetController()))
+		{
+			AIController->StopMovement();
+			if (UBrainComponent* Brain = AIController->GetBrainComponent())
+			{
+				Brain->PauseLogic(TEXT("Pooled"));
+			}
+		}
+	}
+	else
+	{
+		DetachFromControllerPendingDestroy();
+	}
+	GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	GetCharacterMovement()->DisableMovement();
+	GetCharacterMovement()->SetComponentTickEnabled(false);
+	Ragdolls->AddCorpse(this);
 }
 
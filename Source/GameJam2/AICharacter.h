@@ -4,6 +4,8 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "Perception/PawnSensingComponent.h"
+#include "WeaponDefinition.h"
 #include "AICharacter.generated.h"
 
 UCLASS()
@@ -13,25 +15,74 @@ class GAMEJAM2_API AAICharacter : public ACharacter
 
 public:
 	// Sets default values for this character's properties
-	AAICharacter();
+	AAICharacter(const FObjectInitializer& ObjectInitializer);
 
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
-public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
+public:	
 	// Called to bind functionality to input
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 
 	void Fire();
 
+	//Seconds between shots for this enemy type, used by the AI fire control
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Shooting, meta = (AllowPrivateAccess = "true"))
+	float FireInterval = 0.5f;
+
+	FVector GetMuzzleLocation() const;
+
+	virtual float TakeDamage(float DamageAmount, struct FDamageEvent const& DamageEvent, class AController* EventInstigator, AActor* DamageCauser) override;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = EnemyStats, meta = (AllowPrivateAccess = "true"))
+	int CurrentHealth = 100;
+
+	UFUNCTION(BlueprintCallable)
+	void Die();
+
+	UFUNCTION(BlueprintPure)
+	bool IsDead() const { return bDead; }
+
+	//Weapons a spawner can give this enemy, the index is the spawner's weapon id
+	UPROPERTY(EditDefaultsOnly, Category = Shooting)
+	TArray<FWeaponDefinition> Weapons;
+
+	//Switch to one of Weapons, an invalid index goes back to the class default weapon
+	void EquipWeapon(int32 Weapon);
+
+	//Index into Weapons, -1 for the class default weapon
+	int32 CurrentWeapon = INDEX_NONE;
+
+	//Apply a spawner's stats, Health <= 0 and Weapon < 0 keep the class defaults
+	void InjectStats(int32 Health, int32 Weapon);
+
+	//Called by the enemy pool to wake this enemy up where it has been placed, or to put it back to sleep
+	void ActivateEnemy(int32 Health, int32 Weapon);
+	void DeactivateEnemy();
+
+	bool IsDormant() const { return bDormant; }
+
+	//Pool this enemy goes back to when its corpse is removed, unset for enemies spawned outside the pool
+	TWeakObjectPtr<class UEnemyPoolSubsystem> OwningPool;
+
 private:
 	UFUNCTION()
 	void OnSeePlayer(APawn* pawn);
 
+	//Register with perception, squads, significance and the other AI subsystems
+	void JoinAISystems();
+
+	//Unregister from perception, squads, fire control and the other AI subsystems
+	void LeaveAISystems();
+
+	bool bDead = false;
+
+	//Hidden in the enemy pool with its behaviour tree paused
+	bool bDormant = false;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Shooting, meta = (AllowPrivateAccess = "true"))
 	USceneComponent* MuzzleLocation;
 
@@ -39,13 +90,68 @@ private:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Shooting, meta = (AllowPrivateAccess = "true"))
 	UClass* CurrentProjectileClass;
 
+	//Simulate bullets as data in the projectile simulation instead of spawning actors
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Shooting, meta = (AllowPrivateAccess = "true"))
+	bool bSimulateProjectiles = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Sounds, meta = (AllowPrivateAccess = "true"))
+	class USoundBase* ShootSound;
+
+	//Resolve shots as batched hitscan traces instead of spawning bullets
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Shooting, meta = (AllowPrivateAccess = "true"))
+	bool bHitscan = false;
+
 	//UClass* GeneratedBPBullet = Cast<UClass>(CurrentProjectileClass);
 public:
 
-	UPROPERTY(VisibleAnywhere, Category = "AI")
-	class UPawnSensingComponent* PawnSensingComp;
+	//Sight settings used by the pawn perception subsystem
+	UPROPERTY(EditAnywhere, Category = "AI")
+	float SightRadius = 5000.f;
+
+	//Half angle of the vision cone in degrees **WILL MOST LIKELY CHANGE FOR CONE VISION
+	UPROPERTY(EditAnywhere, Category = "AI")
+	float PeripheralVisionAngle = 90.f;
+
+	//Seconds before a pawn that was seen (or checked) is checked again
+	UPROPERTY(EditAnywhere, Category = "AI")
+	float SensingInterval = 0.5f;
+
+	//Called by the pawn perception subsystem when this enemy sees a pawn
+	UPROPERTY(BlueprintAssignable, Category = "AI")
+	FSeePawnDelegate OnSeePawn;
 
 	UPROPERTY(EditAnywhere, Category = "AI")
 	class UBehaviorTree* BehaviorTree;
 
+	//Chase targets along the shared flow field instead of pathfinding per enemy.
+	//Off until the behaviour tree's MoveTo is taken out, the two would fight over the same pawn
+	UPROPERTY(EditAnywhere, Category = "AI")
+	bool bUseFlowField = false;
+
+	//Drawn instanced for this enemy while it is far away and not an actor, no mesh keeps it an actor always
+	UPROPERTY(EditDefaultsOnly, Category = "AI")
+	class UStaticMesh* CrowdMesh;
+
+	//Level of detail tier given by the AI significance subsystem, 0 is full detail
+	int32 LODTier = 0;
+
+	//Set while the fire control has this enemy engaged, engaged enemies always stay at full detail
+	bool bEngaged = false;
+
+	//Seconds between vision cone checks, set from the LOD tier
+	float PerceptionUpdateInterval = 0.f;
+
+	//World time of this enemy's next vision cone check
+	float NextPerceptionTime = 0.f;
+
+	//Speed of this enemy's bullets, used to lead moving targets. 0 for hitscan
+	float ProjectileSpeed = 0.f;
+
+	//Target choice is made by this enemy's squad rather than by the enemy
+	bool bInSquad = false;
+
+	//Where the squad wants this enemy to fire from, while bHasSquadSlot. Only flow field steering heads for it, EnemyBT has no key for it
+	bool bHasSquadSlot = false;
+	FVector SquadSlot = FVector::ZeroVector;
+
 };
@@ -0,0 +1,256 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AIDecisionSubsystem.h"
+#include "GameJam2.h"
+#include "AICharacter.h"
+#include "MyAIController.h"
+#include "GameJam2Character.h"
+#include "Async/ParallelFor.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("AI Decision Snapshot"), STAT_AIDecisionSnapshot, STATGROUP_GameJam2);
+DECLARE_CYCLE_STAT(TEXT("AI Decision Wait"), STAT_AIDecisionWait, STATGROUP_GameJam2);
+DECLARE_CYCLE_STAT(TEXT("AI Decision Apply"), STAT_AIDecisionApply, STATGROUP_GameJam2);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("AI Decision Evaluate (ms)"), STAT_AIDecisionEvaluate, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("AI Decision Enemies"), STAT_AIDecisionEnemies, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("AI Decision Target Changes"), STAT_AIDecisionTargetChanges, STATGROUP_GameJam2);
+
+void UAIDecisionSubsystem::Deinitialize()
+{
+	//The task reads our buffers, don't let it outlive them
+	WaitForEvaluation();
+	Super::Deinitialize();
+}
+
+bool UAIDecisionSubsystem::IsTickable() const
+{
+	return Enemies.Num() > 0 || EvaluationTask.IsValid();
+}
+
+ETickableTickType UAIDecisionSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId UAIDecisionSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UAIDecisionSubsystem, STATGROUP_Tickables);
+}
+
+void UAIDecisionSubsystem::RegisterEnemy(AAICharacter* Enemy)
+{
+	if (Enemy)
+	{
+		Enemies.AddUnique(Enemy);
+	}
+}
+
+void UAIDecisionSubsystem::UnregisterEnemy(AAICharacter* Enemy)
+{
+	Enemies.RemoveSwap(Enemy);
+	PendingSights.Remove(Enemy);
+}
+
+void UAIDecisionSubsystem::ReportSeen(AAICharacter* Enemy, APawn* Pawn)
+{
+	if (Enemy && Pawn)
+	{
+		PendingSights.Add(Enemy, Pawn);
+	}
+}
+
+void UAIDecisionSubsystem::Tick(float DeltaTime)
+{
+	//Copy this frame's state into the free buffer while last frame's evaluation may still be running
+	const int32 BackSnapshot = 1 - EvaluatingSnapshot;
+	{
+		SCOPE_CYCLE_COUNTER(STAT_AIDecisionSnapshot);
+		BuildSnapshot(Snapshots[BackSnapshot]);
+	}
+
+	const bool bHadEvaluation = EvaluationTask.IsValid();
+	{
+		SCOPE_CYCLE_COUNTER(STAT_AIDecisionWait);
+		WaitForEvaluation();
+	}
+
+	if (bHadEvaluation)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_AIDecisionApply);
+		ApplyCommands(Snapshots[EvaluatingSnapshot]);
+		SET_FLOAT_STAT(STAT_AIDecisionEvaluate, LastEvaluateSeconds * 1000.0);
+	}
+
+	EvaluatingSnapshot = BackSnapshot;
+	SET_DWORD_STAT(STAT_AIDecisionEnemies, Snapshots[BackSnapshot].Enemies.Num());
+	if (Snapshots[BackSnapshot].Enemies.Num() == 0)
+	{
+		return;
+	}
+
+	Commands.SetNumUninitialized(Snapshots[BackSnapshot].Enemies.Num(), false);
+	EvaluationTask = FFunctionGraphTask::CreateAndDispatchWhenReady([this, BackSnapshot]()
+	{
+		Evaluate(Snapshots[BackSnapshot]);
+	}, TStatId(), nullptr, ENamedThreads::AnyHiPriThreadNormalTask);
+}
+
+void UAIDecisionSubsystem::WaitForEvaluation()
+{
+	if (EvaluationTask.IsValid())
+	{
+		FTaskGraphInterface::Get().WaitUntilTaskCompletes(EvaluationTask, ENamedThreads::GameThread);
+		EvaluationTask = nullptr;
+	}
+}
+
+int32 UAIDecisionSubsystem::AddTarget(FAIWorldSnapshot& Snapshot, TMap<AActor*, int32>& TargetIndices, AActor* Target)
+{
+	if (!Target)
+	{
+		return INDEX_NONE;
+	}
+	if (const int32* Existing = TargetIndices.Find(Target))
+	{
+		return *Existing;
+	}
+
+	//The player counts as dead once their health runs out, even before the actor goes
+	const AGameJam2Character* Player = Cast<AGameJam2Character>(Target);
+	FAITargetSnapshot& Entry = Snapshot.Targets.AddDefaulted_GetRef();
+	Entry.Location = Target->GetActorLocation();
+	Entry.Velocity = Target->GetVelocity();
+	Entry.bAlive = !Target->IsPendingKill() && (!Player || Player->CurrentHealth > 0);
+	Snapshot.TargetActors.Add(Target);
+	return TargetIndices.Add(Target, Snapshot.Targets.Num() - 1);
+}
+
+void UAIDecisionSubsystem::BuildSnapshot(FAIWorldSnapshot& Snapshot)
+{
+	Snapshot.Reset();
+
+	//Most enemies chase the same player, so there are only ever a handful of targets
+	TMap<AActor*, int32> TargetIndices;
+	for (int32 i = Enemies.Num() - 1; i >= 0; i--)
+	{
+		AAICharacter* Enemy = Enemies[i].Get();
+		if (!Enemy)
+		{
+			Enemies.RemoveAtSwap(i, 1, false);
+			continue;
+		}
+		AMyAIController* Controller = Cast<AMyAIController>(Enemy->GetController());
+		if (!Controller)
+		{
+			continue;
+		}
+
+		APawn* Seen = nullptr;
+		if (TWeakObjectPtr<APawn>* Sight = PendingSights.Find(Enemy))
+		{
+			Seen = Sight->Get();
+		}
+
+		FAIEnemySnapshot& Entry = Snapshot.Enemies.AddDefaulted_GetRef();
+		Entry.Location = Enemy->GetActorLocation();
+		Entry.ProjectileSpeed = Enemy->ProjectileSpeed;
+		Entry.CurrentTarget = AddTarget(Snapshot, TargetIndices, Controller->GetSeenTarget());
+		Entry.SeenTarget = AddTarget(Snapshot, TargetIndices, Seen);
+		Entry.bSquadTargeted = Enemy->bInSquad;
+		Snapshot.EnemyActors.Add(Enemy);
+	}
+	PendingSights.Reset();
+}
+
+void UAIDecisionSubsystem::Evaluate(const FAIWorldSnapshot& Snapshot)
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	//Only the snapshot and these copies are read here, nothing on the game thread
+	const float LoseDistanceSq = LoseTargetDistance * LoseTargetDistance;
+	const float SwitchRatioSq = SwitchTargetRatio * SwitchTargetRatio;
+	const float LeadTime = MaxLeadTime;
+	const int32 NumEnemies = Snapshot.Enemies.Num();
+	const int32 BatchSize = FMath::Max(EvaluateBatchSize, 1);
+
+	ParallelFor(FMath::DivideAndRoundUp(NumEnemies, BatchSize), [&](int32 Batch)
+	{
+		const int32 End = FMath::Min((Batch + 1) * BatchSize, NumEnemies);
+		for (int32 i = Batch * BatchSize; i < End; i++)
+		{
+			const FAIEnemySnapshot& Enemy = Snapshot.Enemies[i];
+			FAIDecisionCommand& Command = Commands[i];
+			Command.bChangeTarget = false;
+			Command.bFocus = false;
+
+			//Squad members keep whatever their squad chose, everyone else picks for themselves
+			int32 Target = Enemy.CurrentTarget;
+			if (!Enemy.bSquadTargeted)
+			{
+				//Drop targets that died or got away
+				float TargetDistSq = Target != INDEX_NONE ? FVector::DistSquared(Enemy.Location, Snapshot.Targets[Target].Location) : MAX_flt;
+				if (Target != INDEX_NONE && (!Snapshot.Targets[Target].bAlive || TargetDistSq > LoseDistanceSq))
+				{
+					Target = INDEX_NONE;
+					TargetDistSq = MAX_flt;
+					Command.bChangeTarget = true;
+				}
+
+				//Take a newly seen pawn if there is no target, or it is clearly closer than the current one
+				if (Enemy.SeenTarget != INDEX_NONE && Enemy.SeenTarget != Target && Snapshot.Targets[Enemy.SeenTarget].bAlive)
+				{
+					const float SeenDistSq = FVector::DistSquared(Enemy.Location, Snapshot.Targets[Enemy.SeenTarget].Location);
+					if (Target == INDEX_NONE || SeenDistSq < TargetDistSq * SwitchRatioSq)
+					{
+						Target = Enemy.SeenTarget;
+						Command.bChangeTarget = true;
+					}
+				}
+			}
+			Command.NewTarget = Target;
+
+			//Aim where the target will be when the bullet gets there
+			if (Target != INDEX_NONE)
+			{
+				const FAITargetSnapshot& TargetState = Snapshot.Targets[Target];
+				const float Lead = Enemy.ProjectileSpeed > 0.f ? FMath::Min(FVector::Dist(Enemy.Location, TargetState.Location) / Enemy.ProjectileSpeed, LeadTime) : 0.f;
+				Command.bFocus = true;
+				Command.FocalPoint = TargetState.Location + TargetState.Velocity * Lead;
+			}
+		}
+	});
+
+	LastEvaluateSeconds = FPlatformTime::Seconds() - StartTime;
+}
+
+void UAIDecisionSubsystem::ApplyCommands(const FAIWorldSnapshot& Snapshot)
+{
+	int32 TargetChanges = 0;
+	for (int32 i = 0; i < Snapshot.EnemyActors.Num(); i++)
+	{
+		AAICharacter* Enemy = Snapshot.EnemyActors[i].Get();
+		AMyAIController* Controller = Enemy ? Cast<AMyAIController>(Enemy->GetController()) : nullptr;
+		if (!Controller)
+		{
+			continue;
+		}
+
+		const FAIDecisionCommand& Command = Commands[i];
+		if (Command.bChangeTarget)
+		{
+			AActor* Target = Command.NewTarget != INDEX_NONE ? Snapshot.TargetActors[Command.NewTarget].Get() : nullptr;
+			Controller->SetSeenTarget(Cast<APawn>(Target));
+			if (!Target)
+			{
+				Controller->ClearFocus(EAIFocusPriority::Gameplay);
+			}
+			TargetChanges++;
+		}
+		if (Command.bFocus)
+		{
+			Controller->SetFocalPoint(Command.FocalPoint);
+		}
+	}
+	SET_DWORD_STAT(STAT_AIDecisionTargetChanges, TargetChanges);
+}
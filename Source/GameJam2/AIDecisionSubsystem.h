@@ -0,0 +1,129 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "AIDecisionSubsystem.generated.h"
+
+class AAICharacter;
+
+//What an enemy knew at the start of the frame
+struct FAIEnemySnapshot
+{
+	FVector Location;
+	float ProjectileSpeed;
+	//Indices into the snapshot's targets, INDEX_NONE for none
+	int32 CurrentTarget;
+	int32 SeenTarget;
+	//Squad members only aim here, their squad chooses the target
+	bool bSquadTargeted;
+};
+
+//A pawn an enemy is chasing or has just seen
+struct FAITargetSnapshot
+{
+	FVector Location;
+	FVector Velocity;
+	bool bAlive;
+};
+
+//What an enemy decided, applied back on the game thread
+struct FAIDecisionCommand
+{
+	bool bChangeTarget;
+	int32 NewTarget;
+	bool bFocus;
+	FVector FocalPoint;
+};
+
+//One frame of world state plus the actors it was read from, which only the game thread touches
+struct FAIWorldSnapshot
+{
+	TArray<FAIEnemySnapshot> Enemies;
+	TArray<FAITargetSnapshot> Targets;
+	TArray<TWeakObjectPtr<AAICharacter>> EnemyActors;
+	TArray<TWeakObjectPtr<AActor>> TargetActors;
+
+	void Reset()
+	{
+		Enemies.Reset();
+		Targets.Reset();
+		EnemyActors.Reset();
+		TargetActors.Reset();
+	}
+};
+
+/**
+ * Runs enemy decisions (which target to chase, where to aim) off the game thread.
+ * Each frame a compact snapshot is copied into one buffer while last frame's snapshot in the other
+ * buffer is evaluated by a ParallelFor in a background task. The resulting commands are applied on
+ * the game thread the next frame, so decisions lag the world by one frame.
+ */
+UCLASS(config = Game)
+class GAMEJAM2_API UAIDecisionSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End FTickableGameObject interface
+
+	void RegisterEnemy(AAICharacter* Enemy);
+	void UnregisterEnemy(AAICharacter* Enemy);
+
+	//Called from perception, the enemy decides whether to take the pawn as its target next update
+	void ReportSeen(AAICharacter* Enemy, APawn* Pawn);
+
+	//Targets further away than this are dropped
+	UPROPERTY(Config)
+	float LoseTargetDistance = 8000.f;
+
+	//A newly seen pawn replaces the current target when it is this fraction of the distance or closer
+	UPROPERTY(Config)
+	float SwitchTargetRatio = 0.6f;
+
+	//Longest the aim is led in front of a moving target
+	UPROPERTY(Config)
+	float MaxLeadTime = 0.5f;
+
+	//Enemies per ParallelFor batch
+	UPROPERTY(Config)
+	int32 EvaluateBatchSize = 32;
+
+private:
+	void BuildSnapshot(FAIWorldSnapshot& Snapshot);
+
+	int32 AddTarget(FAIWorldSnapshot& Snapshot, TMap<AActor*, int32>& TargetIndices, AActor* Target);
+
+	void Evaluate(const FAIWorldSnapshot& Snapshot);
+
+	void ApplyCommands(const FAIWorldSnapshot& Snapshot);
+
+	void WaitForEvaluation();
+
+	TArray<TWeakObjectPtr<AAICharacter>> Enemies;
+
+	TMap<TWeakObjectPtr<AAICharacter>, TWeakObjectPtr<APawn>> PendingSights;
+
+	FAIWorldSnapshot Snapshots[2];
+
+	//Buffer the running evaluation reads from
+	int32 EvaluatingSnapshot = 0;
+
+	TArray<FAIDecisionCommand> Commands;
+
+	FGraphEventRef EvaluationTask;
+
+	//Written by the evaluation task, read once it has finished
+	double LastEvaluateSeconds = 0.0;
+};
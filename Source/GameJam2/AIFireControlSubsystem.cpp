@@ -0,0 +1,144 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AIFireControlSubsystem.h"
+#include "GameJam2.h"
+#include "AICharacter.h"
+#include "MyAIController.h"
+#include "Engine/World.h"
+#include "Async/ParallelFor.h"
+
+DECLARE_CYCLE_STAT(TEXT("AI Fire Control"), STAT_AIFireControl, STATGROUP_GameJam2);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("AI Engaged Shooters"), STAT_AIEngagedShooters, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("AI Shots"), STAT_AIShots, STATGROUP_GameJam2);
+
+bool UAIFireControlSubsystem::IsTickable() const
+{
+	return Engaged.Num() > 0;
+}
+
+ETickableTickType UAIFireControlSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId UAIFireControlSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UAIFireControlSubsystem, STATGROUP_Tickables);
+}
+
+void UAIFireControlSubsystem::Engage(AAICharacter* Shooter)
+{
+	if (!Shooter)
+	{
+		return;
+	}
+	for (const FEngagedShooter& Entry : Engaged)
+	{
+		if (Entry.Shooter == Shooter)
+		{
+			return;
+		}
+	}
+
+	//First shot waits one interval so enemies don't all fire the frame they spot the player
+	FEngagedShooter& Entry = Engaged.AddDefaulted_GetRef();
+	Entry.Shooter = Shooter;
+	Shooter->bEngaged = true;
+	Entry.NextFireTime = GetWorld()->GetTimeSeconds() + Shooter->FireInterval;
+	SET_DWORD_STAT(STAT_AIEngagedShooters, Engaged.Num());
+}
+
+void UAIFireControlSubsystem::Disengage(AAICharacter* Shooter)
+{
+	if (Shooter)
+	{
+		Shooter->bEngaged = false;
+	}
+	Engaged.RemoveAllSwap([Shooter](const FEngagedShooter& Entry) { return Entry.Shooter == Shooter; });
+	SET_DWORD_STAT(STAT_AIEngagedShooters, Engaged.Num());
+}
+
+void UAIFireControlSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_AIFireControl);
+
+	UWorld* World = GetWorld();
+	const float Now = World->GetTimeSeconds();
+
+	DueShooters.Reset();
+	TraceStarts.Reset();
+	TraceEnds.Reset();
+	TraceIgnoreA.Reset();
+	TraceIgnoreB.Reset();
+
+	//Drop enemies that died or lost their target first, so the indices gathered below stay valid
+	for (int32 i = Engaged.Num() - 1; i >= 0; i--)
+	{
+		AAICharacter* Shooter = Engaged[i].Shooter.Get();
+		AMyAIController* Controller = Shooter ? Cast<AMyAIController>(Shooter->GetController()) : nullptr;
+		AActor* Target = Controller ? Controller->GetSeenTarget() : nullptr;
+		if (!Target || Target->IsPendingKill())
+		{
+			if (Shooter)
+			{
+				Shooter->bEngaged = false;
+			}
+			Engaged.RemoveAtSwap(i, 1, false);
+		}
+	}
+
+	//Gather the ones due to fire
+	for (int32 i = 0; i < Engaged.Num(); i++)
+	{
+		FEngagedShooter& Entry = Engaged[i];
+		if (Entry.NextFireTime <= Now)
+		{
+			AAICharacter* Shooter = Entry.Shooter.Get();
+			AActor* Target = Cast<AMyAIController>(Shooter->GetController())->GetSeenTarget();
+			DueShooters.Add(i);
+			TraceStarts.Add(Shooter->GetMuzzleLocation());
+			TraceEnds.Add(Target->GetActorLocation());
+			TraceIgnoreA.Add(Shooter);
+			TraceIgnoreB.Add(Target);
+		}
+	}
+	SET_DWORD_STAT(STAT_AIEngagedShooters, Engaged.Num());
+
+	if (DueShooters.Num() == 0)
+	{
+		return;
+	}
+
+	//Line of sight for every due shooter at once
+	HasLineOfSight.SetNumZeroed(DueShooters.Num(), false);
+	const ECollisionChannel Channel = LineOfSightChannel;
+	const int32 BatchSize = FMath::Max(TraceBatchSize, 1);
+	ParallelFor(FMath::DivideAndRoundUp(DueShooters.Num(), BatchSize), [&](int32 Batch)
+	{
+		const int32 End = FMath::Min((Batch + 1) * BatchSize, DueShooters.Num());
+		for (int32 j = Batch * BatchSize; j < End; j++)
+		{
+			FCollisionQueryParams Params(SCENE_QUERY_STAT(AIFireLineOfSight), false, TraceIgnoreA[j]);
+			Params.AddIgnoredActor(TraceIgnoreB[j]);
+			HasLineOfSight[j] = World->LineTraceTestByChannel(TraceStarts[j], TraceEnds[j], Channel, Params) ? 0 : 1;
+		}
+	});
+
+	//Fire on the game thread
+	for (int32 j = 0; j < DueShooters.Num(); j++)
+	{
+		if (!HasLineOfSight[j])
+		{
+			continue;
+		}
+
+		FEngagedShooter& Entry = Engaged[DueShooters[j]];
+		AAICharacter* Shooter = Entry.Shooter.Get();
+		Shooter->Fire();
+		INC_DWORD_STAT(STAT_AIShots);
+
+		//Keep the cadence steady, but don't let a long blocked spell bank up shots
+		Entry.NextFireTime = FMath::Max(Entry.NextFireTime + Shooter->FireInterval, Now);
+	}
+}
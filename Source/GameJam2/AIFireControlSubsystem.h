@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "AIFireControlSubsystem.generated.h"
+
+class AAICharacter;
+
+//An enemy that has a target and may shoot at it
+struct FEngagedShooter
+{
+	TWeakObjectPtr<AAICharacter> Shooter;
+	float NextFireTime = 0.f;
+};
+
+/**
+ * Decides when enemies shoot. Only enemies with a valid blackboard Target are looked at,
+ * each fires at its own FireInterval, and only when it has line of sight to the target.
+ * All due shots are checked and fired in one pass per frame.
+ */
+UCLASS(config = Game)
+class GAMEJAM2_API UAIFireControlSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End FTickableGameObject interface
+
+	//Start considering this enemy for firing, called when it gets a target
+	void Engage(AAICharacter* Shooter);
+
+	//Stop considering this enemy, called when it dies or loses its target
+	void Disengage(AAICharacter* Shooter);
+
+	int32 GetNumEngaged() const { return Engaged.Num(); }
+
+	//Channel used for the line of sight check before each shot
+	UPROPERTY(Config)
+	TEnumAsByte<ECollisionChannel> LineOfSightChannel = ECC_Visibility;
+
+	//Enemies per ParallelFor batch for line of sight traces
+	UPROPERTY(Config)
+	int32 TraceBatchSize = 8;
+
+private:
+	TArray<FEngagedShooter> Engaged;
+
+	//Per frame scratch: shooters due to fire and whether they can see their target
+	TArray<int32> DueShooters;
+	TArray<FVector> TraceStarts;
+	TArray<FVector> TraceEnds;
+	TArray<const AActor*> TraceIgnoreA;
+	TArray<const AActor*> TraceIgnoreB;
+	TArray<uint8> HasLineOfSight;
+};
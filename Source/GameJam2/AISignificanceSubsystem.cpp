@@ -0,0 +1,176 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AISignificanceSubsystem.h"
+#include "GameJam2.h"
+#include "AICharacter.h"
+#include "EnemySpawner.h"
+#include "AIController.h"
+#include "BrainComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Kismet/GameplayStatics.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("AI Significance"), STAT_AISignificance, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("AI Tier Changes"), STAT_AITierChanges, STATGROUP_GameJam2);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("AI Enemies Tier 0"), STAT_AITier0, STATGROUP_GameJam2);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("AI Enemies Lowest Tier"), STAT_AITierLowest, STATGROUP_GameJam2);
+
+bool UAISignificanceSubsystem::IsTickable() const
+{
+	return Enemies.Num() > 0 && Tiers.Num() > 0;
+}
+
+ETickableTickType UAISignificanceSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId UAISignificanceSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UAISignificanceSubsystem, STATGROUP_Tickables);
+}
+
+void UAISignificanceSubsystem::RegisterEnemy(AAICharacter* Enemy)
+{
+	if (Enemy)
+	{
+		Enemies.AddUnique(Enemy);
+		//Start everyone at full detail, the next update will move them down one tier at a time.
+		//Pooled enemies come back with the throttling of their last life, so the settings are applied, not just the tier
+		if (Tiers.Num() > 0)
+		{
+			ApplyTier(Enemy, 0);
+		}
+		else
+		{
+			Enemy->LODTier = 0;
+		}
+	}
+}
+
+void UAISignificanceSubsystem::UnregisterEnemy(AAICharacter* Enemy)
+{
+	Enemies.RemoveSwap(Enemy);
+}
+
+void UAISignificanceSubsystem::SetPlayerRoom(AEnemySpawner* Room)
+{
+	PlayerRoom = Room;
+	//Re-rank straight away so the new room wakes up as the player walks in
+	TimeUntilUpdate = 0.f;
+}
+
+void UAISignificanceSubsystem::Tick(float DeltaTime)
+{
+	TimeUntilUpdate -= DeltaTime;
+	if (TimeUntilUpdate > 0.f)
+	{
+		return;
+	}
+	TimeUntilUpdate = UpdateInterval;
+
+	SCOPE_CYCLE_COUNTER(STAT_AISignificance);
+
+	APawn* Player = UGameplayStatics::GetPlayerPawn(this, 0);
+	if (!Player)
+	{
+		return;
+	}
+	const FVector PlayerLocation = Player->GetActorLocation();
+
+	//Work out where everyone wants to be, most significant first so they get the change budget
+	TArray<TPair<float, AAICharacter*>, TInlineAllocator<64>> Ranked;
+	for (int32 i = Enemies.Num() - 1; i >= 0; i--)
+	{
+		AAICharacter* Enemy = Enemies[i].Get();
+		if (!Enemy)
+		{
+			Enemies.RemoveAtSwap(i, 1, false);
+			continue;
+		}
+		Ranked.Emplace(GetSignificanceDistance(Enemy, PlayerLocation), Enemy);
+	}
+	Ranked.Sort([](const TPair<float, AAICharacter*>& A, const TPair<float, AAICharacter*>& B) { return A.Key < B.Key; });
+
+	int32 NumChanges = 0;
+	int32 NumTier0 = 0;
+	int32 NumLowest = 0;
+	for (const TPair<float, AAICharacter*>& Entry : Ranked)
+	{
+		AAICharacter* Enemy = Entry.Value;
+		const int32 Wanted = PickTier(Enemy->LODTier, Entry.Key);
+		if (Wanted != Enemy->LODTier && NumChanges < MaxTierChangesPerUpdate)
+		{
+			//One step at a time so detail fades rather than pops
+			ApplyTier(Enemy, Enemy->LODTier + (Wanted > Enemy->LODTier ? 1 : -1));
+			NumChanges++;
+		}
+		NumTier0 += Enemy->LODTier == 0 ? 1 : 0;
+		NumLowest += Enemy->LODTier == Tiers.Num() - 1 ? 1 : 0;
+	}
+
+	INC_DWORD_STAT_BY(STAT_AITierChanges, NumChanges);
+	SET_DWORD_STAT(STAT_AITier0, NumTier0);
+	SET_DWORD_STAT(STAT_AITierLowest, NumLowest);
+}
+
+float UAISignificanceSubsystem::GetSignificanceDistance(AAICharacter* Enemy, const FVector& PlayerLocation) const
+{
+	//Enemies that are fighting are always fully detailed
+	if (Enemy->bEngaged)
+	{
+		return 0.f;
+	}
+
+	float Distance = FVector::Dist(Enemy->GetActorLocation(), PlayerLocation);
+	if (PlayerRoom.IsValid() && Enemy->GetOwner() == PlayerRoom.Get())
+	{
+		Distance *= SameRoomDistanceScale;
+	}
+	return Distance;
+}
+
+int32 UAISignificanceSubsystem::PickTier(int32 CurrentTier, float Distance) const
+{
+	int32 Tier = Tiers.Num() - 1;
+	for (int32 i = 0; i < Tiers.Num() - 1; i++)
+	{
+		//Staying in (or above) the current tier gets the hysteresis band
+		const float Limit = i >= CurrentTier ? Tiers[i].MaxDistance * (1.f + Hysteresis) : Tiers[i].MaxDistance;
+		if (Distance < Limit)
+		{
+			Tier = i;
+			break;
+		}
+	}
+	return Tier;
+}
+
+void UAISignificanceSubsystem::ApplyTier(AAICharacter* Enemy, int32 Tier)
+{
+	const FAILODTier& Settings = Tiers[Tier];
+	Enemy->LODTier = Tier;
+	Enemy->PerceptionUpdateInterval = Settings.PerceptionInterval;
+
+	//Enemies never tick as actors, the animation budget reads the tier's TickInterval for how often to update the mesh
+	if (USkeletalMeshComponent* Mesh = Enemy->GetMesh())
+	{
+		Mesh->VisibilityBasedAnimTickOption = Settings.bOnlyAnimateWhenRendered ? EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered : EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones;
+	}
+
+	if (UCharacterMovementComponent* Movement = Enemy->GetCharacterMovement())
+	{
+		Movement->SetComponentTickInterval(Settings.MovementInterval);
+		Movement->SetComponentTickEnabled(!Settings.bDisableMovement);
+	}
+
+	if (AAIController* Controller = Cast<AAIController>(Enemy->GetController()))
+	{
+		if (UBrainComponent* Brain = Controller->GetBrainComponent())
+		{
+			Brain->SetComponentTickInterval(Settings.BehaviorTreeInterval);
+		}
+	}
+}
@@ -0,0 +1,107 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "AISignificanceSubsystem.generated.h"
+
+class AAICharacter;
+class AEnemySpawner;
+
+//How much an enemy is updated at one level of detail
+USTRUCT()
+struct FAILODTier
+{
+	GENERATED_BODY()
+
+	//Enemies with a significance distance under this use this tier (the last tier catches everything else)
+	UPROPERTY(Config)
+	float MaxDistance = 0.f;
+
+	//Seconds between animation updates of the skeletal mesh, 0 is every frame
+	UPROPERTY(Config)
+	float TickInterval = 0.f;
+
+	//Tick interval for the behaviour tree
+	UPROPERTY(Config)
+	float BehaviorTreeInterval = 0.f;
+
+	//Tick interval for character movement
+	UPROPERTY(Config)
+	float MovementInterval = 0.f;
+
+	//Seconds between vision cone checks in the pawn perception
+	UPROPERTY(Config)
+	float PerceptionInterval = 0.f;
+
+	//Turn character movement off completely
+	UPROPERTY(Config)
+	bool bDisableMovement = false;
+
+	//Only animate the mesh when it is on screen
+	UPROPERTY(Config)
+	bool bOnlyAnimateWhenRendered = false;
+};
+
+/**
+ * Ranks enemies by distance to the player and by room, and gives each a level of detail tier
+ * that sets how often it ticks, thinks, moves and looks around.
+ * Enemies only move one tier per update and need to clear a hysteresis band to drop a tier, so changes don't pop.
+ */
+UCLASS(config = Game)
+class GAMEJAM2_API UAISignificanceSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End FTickableGameObject interface
+
+	void RegisterEnemy(AAICharacter* Enemy);
+	void UnregisterEnemy(AAICharacter* Enemy);
+
+	//Called when the player walks into a spawner's room
+	void SetPlayerRoom(AEnemySpawner* Room);
+
+	AEnemySpawner* GetPlayerRoom() const { return PlayerRoom.Get(); }
+
+	//Tiers from most to least detailed
+	UPROPERTY(Config)
+	TArray<FAILODTier> Tiers;
+
+	//Seconds between re-ranking
+	UPROPERTY(Config)
+	float UpdateInterval = 0.25f;
+
+	//Fraction past a tier's MaxDistance an enemy has to be before it drops to the next tier
+	UPROPERTY(Config)
+	float Hysteresis = 0.15f;
+
+	//Enemies in the player's current room are ranked as if they were this much closer
+	UPROPERTY(Config)
+	float SameRoomDistanceScale = 0.5f;
+
+	//Most tier changes applied per update, the rest wait for the next update
+	UPROPERTY(Config)
+	int32 MaxTierChangesPerUpdate = 8;
+
+private:
+	float GetSignificanceDistance(AAICharacter* Enemy, const FVector& PlayerLocation) const;
+
+	int32 PickTier(int32 CurrentTier, float Distance) const;
+
+	void ApplyTier(AAICharacter* Enemy, int32 Tier);
+
+	TArray<TWeakObjectPtr<AAICharacter>> Enemies;
+
+	TWeakObjectPtr<AEnemySpawner> PlayerRoom;
+
+	float TimeUntilUpdate = 0.f;
+};
@@ -0,0 +1,209 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AISquadSubsystem.h"
+#include "GameJam2.h"
+#include "AICharacter.h"
+#include "MyAIController.h"
+#include "GameJam2Character.h"
+#include "TacticalGridSubsystem.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("AI Squads"), STAT_AISquads, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("AI Squad Decisions"), STAT_AISquadDecisions, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("AI Squad Member Writes"), STAT_AISquadWrites, STATGROUP_GameJam2);
+
+bool UAISquadSubsystem::IsTickable() const
+{
+	return Squads.Num() > 0;
+}
+
+ETickableTickType UAISquadSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId UAISquadSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UAISquadSubsystem, STATGROUP_Tickables);
+}
+
+FAISquad* UAISquadSubsystem::FindSquad(const AActor* Room)
+{
+	for (FAISquad& Squad : Squads)
+	{
+		if (Squad.Room.Get() == Room)
+		{
+			return &Squad;
+		}
+	}
+	return nullptr;
+}
+
+bool UAISquadSubsystem::JoinSquad(AAICharacter* Enemy)
+{
+	AActor* Room = Enemy ? Enemy->GetOwner() : nullptr;
+	if (!Room)
+	{
+		return false;
+	}
+
+	FAISquad* Squad = FindSquad(Room);
+	if (!Squad)
+	{
+		Squad = &Squads.AddDefaulted_GetRef();
+		Squad->Room = Room;
+	}
+	Squad->Members.AddUnique(Enemy);
+	//Late joiners pick up the squad's target straight away
+	Squad->bDirty = true;
+	Enemy->bInSquad = true;
+	return true;
+}
+
+void UAISquadSubsystem::LeaveSquad(AAICharacter* Enemy)
+{
+	if (FAISquad* Squad = Enemy ? FindSquad(Enemy->GetOwner()) : nullptr)
+	{
+		Squad->Members.RemoveSwap(Enemy);
+		Squad->bDirty = true;
+	}
+}
+
+void UAISquadSubsystem::ReportSeen(AAICharacter* Enemy, APawn* Pawn)
+{
+	if (FAISquad* Squad = Enemy ? FindSquad(Enemy->GetOwner()) : nullptr)
+	{
+		Squad->SeenTarget = Pawn;
+	}
+}
+
+void UAISquadSubsystem::Tick(float DeltaTime)
+{
+	TimeUntilDecision -= DeltaTime;
+	if (TimeUntilDecision > 0.f)
+	{
+		return;
+	}
+	TimeUntilDecision = DecisionInterval;
+
+	SCOPE_CYCLE_COUNTER(STAT_AISquads);
+
+	for (int32 i = Squads.Num() - 1; i >= 0; i--)
+	{
+		FAISquad& Squad = Squads[i];
+		Squad.Members.RemoveAllSwap([](const TWeakObjectPtr<AAICharacter>& Member) { return !Member.IsValid(); });
+		if (Squad.Members.Num() == 0 && !Squad.Room.IsValid())
+		{
+			Squads.RemoveAtSwap(i, 1, false);
+			continue;
+		}
+		DecideForSquad(Squad);
+	}
+	SET_DWORD_STAT(STAT_AISquadDecisions, Squads.Num());
+}
+
+void UAISquadSubsystem::DecideForSquad(FAISquad& Squad)
+{
+	if (Squad.Members.Num() == 0)
+	{
+		return;
+	}
+
+	//Drop a target that died or got away from the whole squad
+	APawn* Target = Squad.Target.Get();
+	if (Target)
+	{
+		const AGameJam2Character* Player = Cast<AGameJam2Character>(Target);
+		bool bInRange = false;
+		for (const TWeakObjectPtr<AAICharacter>& Member : Squad.Members)
+		{
+			if (FVector::DistSquared(Member->GetActorLocation(), Target->GetActorLocation()) < LoseTargetDistance * LoseTargetDistance)
+			{
+				bInRange = true;
+				break;
+			}
+		}
+		if (Target->IsPendingKill() || (Player && Player->CurrentHealth <= 0) || !bInRange)
+		{
+			Target = nullptr;
+		}
+	}
+
+	//Whoever a member saw becomes the squad's target if it has none
+	if (!Target && Squad.SeenTarget.IsValid())
+	{
+		Target = Squad.SeenTarget.Get();
+	}
+	Squad.SeenTarget = nullptr;
+
+	if (Target != Squad.Target.Get())
+	{
+		Squad.Target = Target;
+		Squad.bDirty = true;
+	}
+
+	//Slots follow the target around, so they are refreshed every decision while there is one
+	if (Target || Squad.bDirty)
+	{
+		AssignSlots(Squad);
+		Squad.bDirty = false;
+	}
+}
+
+void UAISquadSubsystem::AssignSlots(FAISquad& Squad)
+{
+	APawn* Target = Squad.Target.Get();
+	const int32 NumMembers = Squad.Members.Num();
+
+	//Spread the slots in an arc facing the squad, centred on the line from the target to the squad
+	FVector Centroid = FVector::ZeroVector;
+	for (const TWeakObjectPtr<AAICharacter>& Member : Squad.Members)
+	{
+		Centroid += Member->GetActorLocation();
+	}
+	Centroid /= NumMembers;
+	const FVector TargetLocation = Target ? Target->GetActorLocation() : Centroid;
+	const float BaseYaw = (Centroid - TargetLocation).Rotation().Yaw;
+
+	//Hand out slots in the order members already stand around the target, so nobody crosses over
+	TArray<TPair<float, int32>, TInlineAllocator<16>> Order;
+	for (int32 i = 0; i < NumMembers; i++)
+	{
+		const float MemberYaw = (Squad.Members[i]->GetActorLocation() - TargetLocation).Rotation().Yaw;
+		Order.Emplace(FMath::FindDeltaAngleDegrees(BaseYaw, MemberYaw), i);
+	}
+	Order.Sort([](const TPair<float, int32>& A, const TPair<float, int32>& B) { return A.Key < B.Key; });
+
+	//Nudge slots into nearby cover from the target when the level has a baked tactical grid
+	const UTacticalGridSubsystem* TacticalGrid = GetWorld()->GetSubsystem<UTacticalGridSubsystem>();
+	const bool bUseCover = TacticalGrid && TacticalGrid->IsLoaded();
+
+	for (int32 i = 0; i < NumMembers; i++)
+	{
+		AAICharacter* Member = Squad.Members[Order[i].Value].Get();
+		AMyAIController* Controller = Cast<AMyAIController>(Member->GetController());
+		if (!Controller)
+		{
+			continue;
+		}
+
+		if (Squad.bDirty)
+		{
+			Controller->SetSeenTarget(Target);
+		}
+
+		Member->bHasSquadSlot = Target != nullptr;
+		if (Target)
+		{
+			const float Yaw = BaseYaw + (i - (NumMembers - 1) * 0.5f) * SlotSpacing;
+			Member->SquadSlot = TargetLocation + FRotator(0.f, Yaw, 0.f).Vector() * SlotDistance;
+			FVector CoverSlot;
+			if (bUseCover && TacticalGrid->FindCoverNear(Member->SquadSlot, TargetLocation, CoverSearchCells, CoverSlot))
+			{
+				Member->SquadSlot = CoverSlot;
+			}
+		}
+	}
+	INC_DWORD_STAT_BY(STAT_AISquadWrites, NumMembers);
+}
@@ -0,0 +1,82 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "AISquadSubsystem.generated.h"
+
+class AAICharacter;
+
+//Enemies from one spawner, sharing a target
+struct FAISquad
+{
+	TWeakObjectPtr<AActor> Room;
+	TArray<TWeakObjectPtr<AAICharacter>> Members;
+	TWeakObjectPtr<APawn> Target;
+	//Seen by a member since the last decision
+	TWeakObjectPtr<APawn> SeenTarget;
+	//Members need the target written to their blackboards
+	bool bDirty = false;
+};
+
+/**
+ * Groups enemies by the spawner that made them. Target choice happens once per squad and is written to
+ * every member, and each member gets a slot in an arc around the target to fire from, so the work grows
+ * with the number of squads instead of the number of enemies.
+ */
+UCLASS(config = Game)
+class GAMEJAM2_API UAISquadSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End FTickableGameObject interface
+
+	//Join the squad for the enemy's spawner (its owner), returns false if it has no spawner
+	bool JoinSquad(AAICharacter* Enemy);
+	void LeaveSquad(AAICharacter* Enemy);
+
+	//Called from perception, the squad takes the pawn as its target at the next decision
+	void ReportSeen(AAICharacter* Enemy, APawn* Pawn);
+
+	int32 GetNumSquads() const { return Squads.Num(); }
+
+	//Seconds between squad decisions
+	UPROPERTY(Config)
+	float DecisionInterval = 0.25f;
+
+	//Targets further than this from every member are dropped
+	UPROPERTY(Config)
+	float LoseTargetDistance = 8000.f;
+
+	//How far from the target the fire slots are
+	UPROPERTY(Config)
+	float SlotDistance = 800.f;
+
+	//Degrees between neighbouring fire slots
+	UPROPERTY(Config)
+	float SlotSpacing = 25.f;
+
+	//Cells around a slot searched for cover from the target
+	UPROPERTY(Config)
+	int32 CoverSearchCells = 2;
+
+private:
+	FAISquad* FindSquad(const AActor* Room);
+
+	void DecideForSquad(FAISquad& Squad);
+
+	void AssignSlots(FAISquad& Squad);
+
+	TArray<FAISquad> Squads;
+
+	float TimeUntilDecision = 0.f;
+};
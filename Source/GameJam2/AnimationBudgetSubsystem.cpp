@@ -0,0 +1,203 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AnimationBudgetSubsystem.h"
+#include "GameJam2.h"
+#include "AICharacter.h"
+#include "AISignificanceSubsystem.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Anim Budget"), STAT_AnimBudget, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Anim Evaluated"), STAT_AnimEvaluated, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Anim Skipped"), STAT_AnimSkipped, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Anim Shared"), STAT_AnimShared, STATGROUP_GameJam2);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Anim Evaluate (ms)"), STAT_AnimEvaluateMs, STATGROUP_GameJam2);
+
+//Logs last frame's animation counters, stats aren't drawn in a -nullrhi run
+static FAutoConsoleCommandWithWorld GAnimBudgetStatsCommand(
+	TEXT("GameJam2.AnimBudgetStats"),
+	TEXT("Log evaluated, skipped and shared enemy poses for the last frame"),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		if (UAnimationBudgetSubsystem* Budget = World ? World->GetSubsystem<UAnimationBudgetSubsystem>() : nullptr)
+		{
+			UE_LOG(LogGameJam2, Display, TEXT("Anim budget: %d evaluated, %d skipped, %d shared, %.3f ms"),
+				Budget->LastEvaluated, Budget->LastSkipped, Budget->LastShared, Budget->LastEvaluateMs);
+		}
+	}));
+
+bool UAnimationBudgetSubsystem::IsTickable() const
+{
+	return Entries.Num() > 0;
+}
+
+ETickableTickType UAnimationBudgetSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId UAnimationBudgetSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UAnimationBudgetSubsystem, STATGROUP_Tickables);
+}
+
+void UAnimationBudgetSubsystem::RegisterEnemy(AAICharacter* Enemy)
+{
+	if (!Enemy || !Enemy->GetMesh())
+	{
+		return;
+	}
+
+	//From now on the mesh only animates when we tick it
+	Enemy->GetMesh()->SetComponentTickEnabled(false);
+	FAnimBudgetEntry& Entry = Entries.AddDefaulted_GetRef();
+	Entry.Enemy = Enemy;
+	Entry.LastUpdateTime = GetWorld()->GetTimeSeconds();
+}
+
+void UAnimationBudgetSubsystem::UnregisterEnemy(AAICharacter* Enemy)
+{
+	Entries.RemoveAllSwap([Enemy](const FAnimBudgetEntry& Entry) { return Entry.Enemy == Enemy; });
+	USkeletalMeshComponent* Mesh = Enemy ? Enemy->GetMesh() : nullptr;
+	if (!Mesh)
+	{
+		return;
+	}
+
+	//Give the mesh back its own pose and tick, a ragdoll mustn't keep copying a live leader
+	Mesh->SetMasterPoseComponent(nullptr);
+	Mesh->SetComponentTickEnabled(true);
+
+	//Its followers would copy a ragdoll or hidden mesh until the next regroup, so they animate themselves until then
+	for (FAnimBudgetEntry& Entry : Entries)
+	{
+		AAICharacter* Follower = Entry.Enemy.Get();
+		if (Entry.bFollowing && Follower && Follower->GetMesh()->MasterPoseComponent.Get() == Mesh)
+		{
+			Follower->GetMesh()->SetMasterPoseComponent(nullptr);
+			Entry.bFollowing = false;
+		}
+	}
+	TimeUntilSharingUpdate = 0.f;
+}
+
+void UAnimationBudgetSubsystem::UpdateSharing()
+{
+	//Most detailed enemies first so they become the leaders
+	Entries.Sort([](const FAnimBudgetEntry& A, const FAnimBudgetEntry& B)
+	{
+		const int32 TierA = A.Enemy.IsValid() ? A.Enemy->LODTier : MAX_int32;
+		const int32 TierB = B.Enemy.IsValid() ? B.Enemy->LODTier : MAX_int32;
+		return TierA < TierB;
+	});
+
+	TMap<TPair<USkeletalMesh*, int32>, USkeletalMeshComponent*> Leaders;
+	for (FAnimBudgetEntry& Entry : Entries)
+	{
+		AAICharacter* Enemy = Entry.Enemy.Get();
+		if (!Enemy)
+		{
+			continue;
+		}
+		USkeletalMeshComponent* Mesh = Enemy->GetMesh();
+
+		//Group by skeletal mesh and how fast the enemy is moving
+		const float Speed = Enemy->GetVelocity().Size2D();
+		const int32 SpeedBand = Speed < IdleSpeed ? 0 : 1 + FMath::FloorToInt(Speed / SpeedBandSize);
+		const TPair<USkeletalMesh*, int32> Key(Mesh->SkeletalMesh, SpeedBand);
+
+		USkeletalMeshComponent* Leader = nullptr;
+		if (USkeletalMeshComponent** Found = Leaders.Find(Key))
+		{
+			Leader = Enemy->LODTier >= ShareFromTier ? *Found : nullptr;
+		}
+		else
+		{
+			Leaders.Add(Key, Mesh);
+		}
+
+		if (Mesh->MasterPoseComponent.Get() != Leader)
+		{
+			Mesh->SetMasterPoseComponent(Leader);
+		}
+		Entry.bFollowing = Leader != nullptr;
+	}
+}
+
+void UAnimationBudgetSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_AnimBudget);
+
+	for (int32 i = Entries.Num() - 1; i >= 0; i--)
+	{
+		if (!Entries[i].Enemy.IsValid())
+		{
+			Entries.RemoveAtSwap(i, 1, false);
+		}
+	}
+
+	TimeUntilSharingUpdate -= DeltaTime;
+	if (TimeUntilSharingUpdate <= 0.f)
+	{
+		TimeUntilSharingUpdate = SharingUpdateInterval;
+		UpdateSharing();
+	}
+
+	UWorld* World = GetWorld();
+	const float Now = World->GetTimeSeconds();
+	const UAISignificanceSubsystem* Significance = World->GetSubsystem<UAISignificanceSubsystem>();
+
+	//Work out who wants an update this frame and how overdue they are relative to their tier's rate
+	int32 Skipped = 0;
+	int32 Shared = 0;
+	DueEntries.Reset();
+	for (int32 i = 0; i < Entries.Num(); i++)
+	{
+		FAnimBudgetEntry& Entry = Entries[i];
+		if (Entry.bFollowing)
+		{
+			Entry.LastUpdateTime = Now;
+			Shared++;
+			continue;
+		}
+
+		const int32 Tier = Entry.Enemy->LODTier;
+		const float Interval = Significance && Significance->Tiers.IsValidIndex(Tier) ? Significance->Tiers[Tier].TickInterval : 0.f;
+		const float Age = Now - Entry.LastUpdateTime;
+		if (Age < Interval)
+		{
+			Skipped++;
+			continue;
+		}
+		DueEntries.Emplace(Age / FMath::Max(Interval, DeltaTime), i);
+	}
+	DueEntries.Sort([](const TPair<float, int32>& A, const TPair<float, int32>& B) { return A.Key > B.Key; });
+
+	//Evaluate until the budget runs out, at least one pose always gets through
+	const double BudgetSeconds = BudgetMs * 0.001;
+	const double StartTime = FPlatformTime::Seconds();
+	int32 Evaluated = 0;
+	for (const TPair<float, int32>& Due : DueEntries)
+	{
+		if (Evaluated > 0 && FPlatformTime::Seconds() - StartTime > BudgetSeconds)
+		{
+			break;
+		}
+
+		FAnimBudgetEntry& Entry = Entries[Due.Value];
+		Entry.Enemy->GetMesh()->TickComponent(Now - Entry.LastUpdateTime, LEVELTICK_All, nullptr);
+		Entry.LastUpdateTime = Now;
+		Evaluated++;
+	}
+	Skipped += DueEntries.Num() - Evaluated;
+
+	LastEvaluated = Evaluated;
+	LastSkipped = Skipped;
+	LastShared = Shared;
+	LastEvaluateMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+	SET_DWORD_STAT(STAT_AnimEvaluated, Evaluated);
+	SET_DWORD_STAT(STAT_AnimSkipped, Skipped);
+	SET_DWORD_STAT(STAT_AnimShared, Shared);
+	SET_FLOAT_STAT(STAT_AnimEvaluateMs, LastEvaluateMs);
+}
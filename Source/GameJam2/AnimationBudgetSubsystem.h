@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "AnimationBudgetSubsystem.generated.h"
+
+class AAICharacter;
+
+//Animation bookkeeping for one enemy
+struct FAnimBudgetEntry
+{
+	TWeakObjectPtr<AAICharacter> Enemy;
+	float LastUpdateTime = 0.f;
+	//Copying another enemy's pose instead of animating
+	bool bFollowing = false;
+};
+
+/**
+ * Takes animation updates for enemies off the automatic mesh tick and runs them here under a time budget.
+ * Each enemy wants updating as often as its significance tier's TickInterval, the most overdue go first,
+ * and once the budget is spent the rest keep their last pose until next frame.
+ * Low detail enemies in the same locomotion state share one leader's pose through SetMasterPoseComponent.
+ */
+UCLASS(config = Game)
+class GAMEJAM2_API UAnimationBudgetSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End FTickableGameObject interface
+
+	void RegisterEnemy(AAICharacter* Enemy);
+	void UnregisterEnemy(AAICharacter* Enemy);
+
+	//Milliseconds of animation evaluation allowed per frame
+	UPROPERTY(Config)
+	float BudgetMs = 1.f;
+
+	//Enemies at this significance tier or lower detail may copy another enemy's pose
+	UPROPERTY(Config)
+	int32 ShareFromTier = 2;
+
+	//Seconds between regrouping enemies for pose sharing
+	UPROPERTY(Config)
+	float SharingUpdateInterval = 0.5f;
+
+	//Below this speed an enemy counts as idle
+	UPROPERTY(Config)
+	float IdleSpeed = 10.f;
+
+	//Enemies moving within the same band of this size share a pose
+	UPROPERTY(Config)
+	float SpeedBandSize = 150.f;
+
+	//Counters from the last frame, for the console command and -nullrhi runs
+	int32 LastEvaluated = 0;
+	int32 LastSkipped = 0;
+	int32 LastShared = 0;
+	float LastEvaluateMs = 0.f;
+
+private:
+	void UpdateSharing();
+
+	TArray<FAnimBudgetEntry> Entries;
+
+	//Per frame scratch: entries due an update, most overdue first
+	TArray<TPair<float, int32>> DueEntries;
+
+	float TimeUntilSharingUpdate = 0.f;
+};
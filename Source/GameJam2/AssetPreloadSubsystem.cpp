@@ -0,0 +1,145 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AssetPreloadSubsystem.h"
+#include "GameJam2.h"
+#include "EnemySpawner.h"
+#include "Engine/World.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Preloaded Rooms"), STAT_PreloadedRooms, STATGROUP_GameJam2);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Sync Loads During Play"), STAT_SyncLoadsDuringPlay, STATGROUP_GameJam2);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Room Preload Time (s)"), STAT_RoomPreloadTime, STATGROUP_GameJam2);
+
+static FAutoConsoleCommandWithWorld GPreloadStatsCommand(
+	TEXT("GameJam2.PreloadStats"),
+	TEXT("Log preloaded rooms, their load times and synchronous loads during play"),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		if (UAssetPreloadSubsystem* Preloader = World ? World->GetSubsystem<UAssetPreloadSubsystem>() : nullptr)
+		{
+			UE_LOG(LogGameJam2, Display, TEXT("Preloader: %d rooms loaded, %.3f s last, %.3f s max, %d sync loads during play"),
+				Preloader->RoomsLoaded, Preloader->LastLoadSeconds, Preloader->MaxLoadSeconds, Preloader->SyncLoads);
+		}
+	}));
+
+void UAssetPreloadSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	SyncLoadHandle = FCoreUObjectDelegates::OnSyncLoadPackage.AddUObject(this, &UAssetPreloadSubsystem::OnSyncLoadPackage);
+}
+
+void UAssetPreloadSubsystem::Deinitialize()
+{
+	FCoreUObjectDelegates::OnSyncLoadPackage.Remove(SyncLoadHandle);
+	for (FRoomPreload& Preload : Preloads)
+	{
+		if (Preload.Handle.IsValid())
+		{
+			Preload.Handle->ReleaseHandle();
+		}
+	}
+	Preloads.Empty();
+	Super::Deinitialize();
+}
+
+void UAssetPreloadSubsystem::OnSyncLoadPackage(const FString& PackageName)
+{
+	//Loads while the map is loading are expected, only ones during play hitch
+	UWorld* World = GetWorld();
+	if (!World || !World->IsGameWorld() || !World->HasBegunPlay() || !IsInGameThread())
+	{
+		return;
+	}
+	SyncLoads++;
+	INC_DWORD_STAT(STAT_SyncLoadsDuringPlay);
+	UE_LOG(LogGameJam2, Warning, TEXT("Synchronous load during play: %s"), *PackageName);
+}
+
+void UAssetPreloadSubsystem::PreloadRoom(AEnemySpawner* Room, FStreamableDelegate OnLoaded)
+{
+	if (!Room)
+	{
+		return;
+	}
+
+	//Already asked for, only the callback is new
+	for (FRoomPreload& Preload : Preloads)
+	{
+		if (Preload.Room == Room)
+		{
+			if (Preload.bLoaded)
+			{
+				OnLoaded.ExecuteIfBound();
+			}
+			else
+			{
+				Preload.OnLoaded.Add(OnLoaded);
+			}
+			return;
+		}
+	}
+
+	TArray<FSoftObjectPath> Paths;
+	for (const FEnemySpawnEntry& Entry : Room->GetSpawnSchedule())
+	{
+		if (!Entry.EnemyClass.IsNull())
+		{
+			Paths.AddUnique(Entry.EnemyClass.ToSoftObjectPath());
+		}
+	}
+
+	FRoomPreload& Preload = Preloads.AddDefaulted_GetRef();
+	Preload.Room = Room;
+	Preload.RequestTime = FPlatformTime::Seconds();
+	Preload.OnLoaded.Add(OnLoaded);
+	if (Paths.Num() == 0)
+	{
+		OnRoomLoaded(Room);
+		return;
+	}
+
+	//The callback can run straight away if everything is already in memory, and may add rooms, so find the entry again after
+	TSharedPtr<FStreamableHandle> Handle = StreamableManager.RequestAsyncLoad(Paths, FStreamableDelegate::CreateUObject(this, &UAssetPreloadSubsystem::OnRoomLoaded, TWeakObjectPtr<AEnemySpawner>(Room)));
+	if (FRoomPreload* Added = Preloads.FindByPredicate([Room](const FRoomPreload& Entry) { return Entry.Room == Room; }))
+	{
+		Added->Handle = Handle;
+	}
+}
+
+void UAssetPreloadSubsystem::OnRoomLoaded(TWeakObjectPtr<AEnemySpawner> Room)
+{
+	FRoomPreload* Preload = Preloads.FindByPredicate([&Room](const FRoomPreload& Entry) { return Entry.Room == Room; });
+	if (!Preload || Preload->bLoaded)
+	{
+		return;
+	}
+
+	Preload->bLoaded = true;
+	LastLoadSeconds = float(FPlatformTime::Seconds() - Preload->RequestTime);
+	MaxLoadSeconds = FMath::Max(MaxLoadSeconds, LastLoadSeconds);
+	RoomsLoaded++;
+	INC_DWORD_STAT(STAT_PreloadedRooms);
+	SET_FLOAT_STAT(STAT_RoomPreloadTime, LastLoadSeconds);
+
+	//Callbacks may preload more rooms and move the array, so take them out first
+	TArray<FStreamableDelegate> Callbacks = MoveTemp(Preload->OnLoaded);
+	for (FStreamableDelegate& Callback : Callbacks)
+	{
+		Callback.ExecuteIfBound();
+	}
+}
+
+void UAssetPreloadSubsystem::ReleaseRoom(AEnemySpawner* Room)
+{
+	for (int32 i = Preloads.Num() - 1; i >= 0; i--)
+	{
+		if (Preloads[i].Room == Room)
+		{
+			if (Preloads[i].Handle.IsValid())
+			{
+				Preloads[i].Handle->ReleaseHandle();
+			}
+			Preloads.RemoveAtSwap(i, 1, false);
+		}
+	}
+}
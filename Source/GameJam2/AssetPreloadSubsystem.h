@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/StreamableManager.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "AssetPreloadSubsystem.generated.h"
+
+class AEnemySpawner;
+
+//The classes one room keeps loaded
+struct FRoomPreload
+{
+	TWeakObjectPtr<AEnemySpawner> Room;
+	TSharedPtr<FStreamableHandle> Handle;
+	double RequestTime = 0.0;
+
+	//Waiting for the load to finish
+	TArray<FStreamableDelegate> OnLoaded;
+	bool bLoaded = false;
+};
+
+/**
+ * Streams in the classes a room spawns in the background, so the first enemy of a type doesn't stall on loading.
+ * Loading an enemy class brings its bullets, behaviour tree and weapons with it.
+ * Any package still loaded synchronously on the game thread once play has begun is logged as a warning.
+ */
+UCLASS()
+class GAMEJAM2_API UAssetPreloadSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	//Start loading every class in the room's schedule. OnLoaded runs once they are all in, straight away if they already are
+	void PreloadRoom(AEnemySpawner* Room, FStreamableDelegate OnLoaded = FStreamableDelegate());
+
+	//Let the room's classes unload once nothing else uses them
+	void ReleaseRoom(AEnemySpawner* Room);
+
+	//Rooms whose classes finished loading, and how long that took in seconds
+	int32 RoomsLoaded = 0;
+	float LastLoadSeconds = 0.f;
+	float MaxLoadSeconds = 0.f;
+
+	//Packages loaded synchronously during play
+	int32 SyncLoads = 0;
+
+private:
+	void OnRoomLoaded(TWeakObjectPtr<AEnemySpawner> Room);
+
+	void OnSyncLoadPackage(const FString& PackageName);
+
+	FStreamableManager StreamableManager;
+
+	TArray<FRoomPreload> Preloads;
+
+	FDelegateHandle SyncLoadHandle;
+};
@@ -0,0 +1,115 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BulletProjectile.h"
+#include "ProjectilePoolSubsystem.h"
+#include "GameJam2Character.h"
+#include "Components/SphereComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "GameFramework/ProjectileMovementComponent.h"
+#include "TimerManager.h"
+
+// Sets default values
+ABulletProjectile::ABulletProjectile()
+{
+	//Bullets are moved by the projectile movement component, the actor itself never needs to tick
+	PrimaryActorTick.bCanEverTick = false;
+
+	CollisionComp = CreateDefaultSubobject<USphereComponent>(TEXT("CollisionComp"));
+	CollisionComp->InitSphereRadius(5.f);
+	CollisionComp->SetCollisionProfileName(TEXT("BlockAllDynamic"));
+	RootComponent = CollisionComp;
+
+	BulletMesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("BulletMesh"));
+	BulletMesh->SetupAttachment(RootComponent);
+	BulletMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+
+	ProjectileMovement = CreateDefaultSubobject<UProjectileMovementComponent>(TEXT("ProjectileMovement"));
+	ProjectileMovement->UpdatedComponent = CollisionComp;
+	ProjectileMovement->InitialSpeed = 3000.f;
+	ProjectileMovement->MaxSpeed = 3000.f;
+	ProjectileMovement->ProjectileGravityScale = 0.f;
+	ProjectileMovement->bRotationFollowsVelocity = true;
+	ProjectileMovement->bShouldBounce = false;
+	//Started by ActivateProjectile so pooled bullets can sit dormant
+	ProjectileMovement->bAutoActivate = false;
+	ProjectileMovement->OnProjectileStop.AddDynamic(this, &ABulletProjectile::OnProjectileStop);
+}
+
+void ABulletProjectile::ActivateProjectile(const FVector& Location, const FRotator& Rotation, AActor* NewOwner, float SubFrameAge)
+{
+	bProjectileActive = true;
+	SetOwner(NewOwner);
+	SetInstigator(Cast<APawn>(NewOwner));
+	SetActorLocationAndRotation(Location, Rotation, false, nullptr, ETeleportType::TeleportPhysics);
+
+	//Don't shoot ourselves
+	CollisionComp->ClearMoveIgnoreActors();
+	if (NewOwner)
+	{
+		CollisionComp->IgnoreActorWhenMoving(NewOwner, true);
+	}
+
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+
+	//StopSimulating clears the updated component when the bullet hits something
+	ProjectileMovement->SetUpdatedComponent(CollisionComp);
+	ProjectileMovement->Velocity = Rotation.Vector() * ProjectileMovement->InitialSpeed;
+	ProjectileMovement->Activate(true);
+	ProjectileMovement->UpdateComponentVelocity();
+
+	GetWorldTimerManager().SetTimer(LifeTimeHandle, this, &ABulletProjectile::LifeTimeExpired, MaxLifeTime, false);
+
+	//Catch up on the time since the shot was due, swept so a fast weapon can't skip the bullet past a wall or an enemy
+	if (SubFrameAge > 0.f)
+	{
+		ProjectileMovement->TickComponent(SubFrameAge, LEVELTICK_All, nullptr);
+	}
+}
+
+void ABulletProjectile::DeactivateProjectile()
+{
+	bProjectileActive = false;
+	GetWorldTimerManager().ClearTimer(LifeTimeHandle);
+
+	ProjectileMovement->StopMovementImmediately();
+	ProjectileMovement->Deactivate();
+
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+	SetOwner(nullptr);
+}
+
+void ABulletProjectile::OnProjectileStop(const FHitResult& ImpactResult)
+{
+	if (!bProjectileActive)
+	{
+		return;
+	}
+
+	AActor* OtherActor = ImpactResult.GetActor();
+	if (AGameJam2Character* Player = Cast<AGameJam2Character>(OtherActor))
+	{
+		Player->ReceiveDamage(Damage);
+	}
+	OnBulletImpact(OtherActor, ImpactResult);
+	Retire(true);
+}
+
+void ABulletProjectile::LifeTimeExpired()
+{
+	Retire(false);
+}
+
+void ABulletProjectile::Retire(bool bHit)
+{
+	if (UProjectilePoolSubsystem* Pool = OwningPool.Get())
+	{
+		Pool->ReleaseProjectile(this, bHit);
+	}
+	else
+	{
+		Destroy();
+	}
+}
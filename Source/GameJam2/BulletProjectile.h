@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "BulletProjectile.generated.h"
+
+class UProjectilePoolSubsystem;
+
+/**
+ * Base class for bullets (BasicBulletBP should be parented to this).
+ * Bullets never destroy themselves while they belong to a pool, they are handed back to it instead.
+ */
+UCLASS()
+class GAMEJAM2_API ABulletProjectile : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ABulletProjectile();
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Projectile, meta = (AllowPrivateAccess = "true"))
+	class USphereComponent* CollisionComp;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Projectile, meta = (AllowPrivateAccess = "true"))
+	class UStaticMeshComponent* BulletMesh;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Projectile, meta = (AllowPrivateAccess = "true"))
+	class UProjectileMovementComponent* ProjectileMovement;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Projectile, meta = (AllowPrivateAccess = "true"))
+	int Damage = 10;
+
+	//Seconds before a bullet that hit nothing is retired
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Projectile, meta = (AllowPrivateAccess = "true"))
+	float MaxLifeTime = 3.f;
+
+	//Put the bullet in flight from the given transform. SubFrameAge is simulated straight away, sweeping like any other step
+	void ActivateProjectile(const FVector& Location, const FRotator& Rotation, AActor* NewOwner, float SubFrameAge = 0.f);
+
+	//Hide the bullet and stop all movement, collision and ticking
+	void DeactivateProjectile();
+
+	bool IsProjectileActive() const { return bProjectileActive; }
+
+	//Set by the pool that created this bullet, unpooled bullets are destroyed when retired
+	TWeakObjectPtr<UProjectilePoolSubsystem> OwningPool;
+
+protected:
+	//Lets the blueprint play effects or apply extra damage
+	UFUNCTION(BlueprintImplementableEvent, Category = Projectile)
+	void OnBulletImpact(AActor* OtherActor, const FHitResult& Hit);
+
+private:
+	UFUNCTION()
+	void OnProjectileStop(const FHitResult& ImpactResult);
+
+	//Return to the pool (or destroy if unpooled)
+	void Retire(bool bHit);
+
+	void LifeTimeExpired();
+
+	FTimerHandle LifeTimeHandle;
+	bool bProjectileActive = false;
+};
@@ -0,0 +1,336 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "EnemyCrowdSubsystem.h"
+#include "GameJam2.h"
+#include "AICharacter.h"
+#include "AISignificanceSubsystem.h"
+#include "EnemySpawner.h"
+#include "EnemyPoolSubsystem.h"
+#include "FlowFieldSubsystem.h"
+#include "NavigationSystem.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Kismet/GameplayStatics.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Crowd Simulate"), STAT_CrowdSimulate, STATGROUP_GameJam2);
+DECLARE_CYCLE_STAT(TEXT("Crowd Convert"), STAT_CrowdConvert, STATGROUP_GameJam2);
+DECLARE_CYCLE_STAT(TEXT("Crowd Instances"), STAT_CrowdInstances, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Crowd Rows"), STAT_CrowdRows, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Crowd Promoted Actors"), STAT_CrowdPromoted, STATGROUP_GameJam2);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Crowd Promotions"), STAT_CrowdPromotions, STATGROUP_GameJam2);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Crowd Demotions"), STAT_CrowdDemotions, STATGROUP_GameJam2);
+
+bool UEnemyCrowdSubsystem::IsTickable() const
+{
+	return Positions.Num() > 0 || Promoted.Num() > 0;
+}
+
+ETickableTickType UEnemyCrowdSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId UEnemyCrowdSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UEnemyCrowdSubsystem, STATGROUP_Tickables);
+}
+
+int32 UEnemyCrowdSubsystem::FindOrAddArchetype(UClass* EnemyClass)
+{
+	for (int32 i = 0; i < Archetypes.Num(); i++)
+	{
+		if (Archetypes[i].EnemyClass == EnemyClass)
+		{
+			return i;
+		}
+	}
+
+	FEnemyArchetype& Archetype = Archetypes.AddDefaulted_GetRef();
+	Archetype.EnemyClass = EnemyClass;
+
+	//Speed, size and look all come from the enemy blueprint's defaults
+	const AAICharacter* Defaults = EnemyClass->GetDefaultObject<AAICharacter>();
+	Archetype.Speed = Defaults->GetCharacterMovement()->MaxWalkSpeed;
+	Archetype.HalfHeight = Defaults->GetCapsuleComponent()->GetUnscaledCapsuleHalfHeight();
+	if (Defaults->CrowdMesh)
+	{
+		if (!InstancesActor)
+		{
+			FActorSpawnParameters SpawnParams;
+			SpawnParams.ObjectFlags |= RF_Transient;
+			InstancesActor = GetWorld()->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParams);
+			InstancesActor->SetRootComponent(NewObject<USceneComponent>(InstancesActor, TEXT("Root")));
+			InstancesActor->GetRootComponent()->RegisterComponent();
+		}
+
+		Archetype.Instances = NewObject<UInstancedStaticMeshComponent>(InstancesActor);
+		Archetype.Instances->SetStaticMesh(Defaults->CrowdMesh);
+		Archetype.Instances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		Archetype.Instances->SetMobility(EComponentMobility::Movable);
+		Archetype.Instances->SetupAttachment(InstancesActor->GetRootComponent());
+		Archetype.Instances->RegisterComponent();
+	}
+	return Archetypes.Num() - 1;
+}
+
+void UEnemyCrowdSubsystem::SpawnEnemy(UClass* EnemyClass, const FVector& Location, const FRotator& Rotation, AActor* Room, int32 Health, int32 Weapon)
+{
+	if (!EnemyClass)
+	{
+		return;
+	}
+
+	//Anything that isn't an AI character can't be a row, spawn it as it always was
+	if (!EnemyClass->IsChildOf(AAICharacter::StaticClass()))
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.Owner = Room;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		GetWorld()->SpawnActor<AActor>(EnemyClass, Location, Rotation, SpawnParams);
+		return;
+	}
+
+	const int32 Archetype = FindOrAddArchetype(EnemyClass);
+	APawn* Player = UGameplayStatics::GetPlayerPawn(this, 0);
+	const bool bNearPlayer = !Player || FVector::DistSquared(Player->GetActorLocation(), Location) < PromoteDistance * PromoteDistance;
+	//Enemies without a crowd mesh can't be drawn or hit as a row, they are actors even past the cap
+	if (!Archetypes[Archetype].Instances || (bNearPlayer && Promoted.Num() < MaxPromotedActors))
+	{
+		SpawnPromoted(Archetype, Location, Rotation, Room, Health, Weapon);
+	}
+	else
+	{
+		AddRow(Archetype, Location, Rotation.Yaw, Room, Health, Weapon);
+	}
+}
+
+AAICharacter* UEnemyCrowdSubsystem::SpawnPromoted(int32 Archetype, const FVector& Location, const FRotator& Rotation, AActor* Room, int32 Health, int32 Weapon)
+{
+	UEnemyPoolSubsystem* Pool = GetWorld()->GetSubsystem<UEnemyPoolSubsystem>();
+	AAICharacter* Enemy = Pool ? Pool->AcquireEnemy(Archetypes[Archetype].EnemyClass, Location, Rotation, Room, Health, Weapon) : nullptr;
+	if (Enemy)
+	{
+		Promoted.Add({ Enemy, Archetype });
+	}
+	return Enemy;
+}
+
+bool UEnemyCrowdSubsystem::ProjectToNavMesh(int32 Archetype, FVector& InOutLocation) const
+{
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	FNavLocation Projected;
+	const float HalfHeight = Archetypes[Archetype].HalfHeight;
+	if (!NavSys || !NavSys->ProjectPointToNavigation(InOutLocation, Projected, FVector(PromoteProjectionRadius, PromoteProjectionRadius, HalfHeight * 2.f)))
+	{
+		return false;
+	}
+	InOutLocation = Projected.Location + FVector(0.f, 0.f, HalfHeight);
+	return true;
+}
+
+void UEnemyCrowdSubsystem::AddRow(int32 Archetype, const FVector& Location, float Yaw, AActor* Room, int32 Health, int32 Weapon)
+{
+	//Rows steer along the flow field, keep it built while there are any
+	if (Positions.Num() == 0)
+	{
+		if (UFlowFieldSubsystem* FlowField = GetWorld()->GetSubsystem<UFlowFieldSubsystem>())
+		{
+			FlowField->AddFieldUser();
+		}
+	}
+
+	Positions.Add(Location);
+	Velocities.Add(FVector::ZeroVector);
+	Yaws.Add(Yaw);
+	Healths.Add(Health);
+	RowWeapons.Add(int8(FMath::Clamp(Weapon, -1, 127)));
+	RowArchetypes.Add(uint16(Archetype));
+	Rooms.Add(Room);
+}
+
+void UEnemyCrowdSubsystem::RemoveRow(int32 Index)
+{
+	Positions.RemoveAtSwap(Index, 1, false);
+	Velocities.RemoveAtSwap(Index, 1, false);
+	Yaws.RemoveAtSwap(Index, 1, false);
+	Healths.RemoveAtSwap(Index, 1, false);
+	RowWeapons.RemoveAtSwap(Index, 1, false);
+	RowArchetypes.RemoveAtSwap(Index, 1, false);
+	Rooms.RemoveAtSwap(Index, 1, false);
+
+	if (Positions.Num() == 0)
+	{
+		if (UFlowFieldSubsystem* FlowField = GetWorld()->GetSubsystem<UFlowFieldSubsystem>())
+		{
+			FlowField->RemoveFieldUser();
+		}
+	}
+}
+
+void UEnemyCrowdSubsystem::Tick(float DeltaTime)
+{
+	APawn* Player = UGameplayStatics::GetPlayerPawn(this, 0);
+	if (!Player)
+	{
+		return;
+	}
+	const FVector PlayerLocation = Player->GetActorLocation();
+
+	SimulateRows(DeltaTime, PlayerLocation);
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_CrowdConvert);
+		ConversionsThisFrame = 0;
+		DemoteEnemies(PlayerLocation);
+		PromoteRows(PlayerLocation);
+	}
+
+	UpdateInstances();
+
+	SET_DWORD_STAT(STAT_CrowdRows, Positions.Num());
+	SET_DWORD_STAT(STAT_CrowdPromoted, Promoted.Num());
+}
+
+void UEnemyCrowdSubsystem::SimulateRows(float DeltaTime, const FVector& PlayerLocation)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CrowdSimulate);
+
+	UWorld* World = GetWorld();
+	const UAISignificanceSubsystem* Significance = World->GetSubsystem<UAISignificanceSubsystem>();
+	const UFlowFieldSubsystem* FlowField = World->GetSubsystem<UFlowFieldSubsystem>();
+	const AActor* PlayerRoom = Significance ? Significance->GetPlayerRoom() : nullptr;
+	const float ChaseDistanceSq = ChaseDistance * ChaseDistance;
+
+	for (int32 i = 0; i < Positions.Num(); i++)
+	{
+		//Rows only chase once the player is in their room or close, otherwise they wait where they are
+		const bool bChasing = (PlayerRoom && Rooms[i].Get() == PlayerRoom) || FVector::DistSquared(Positions[i], PlayerLocation) < ChaseDistanceSq;
+		if (!bChasing)
+		{
+			Velocities[i] = FVector::ZeroVector;
+			continue;
+		}
+
+		FVector Direction;
+		if (!FlowField || !FlowField->SampleDirection(Positions[i], Direction))
+		{
+			Direction = (PlayerLocation - Positions[i]).GetSafeNormal2D();
+		}
+		Velocities[i] = Direction * Archetypes[RowArchetypes[i]].Speed;
+		Positions[i] += Velocities[i] * DeltaTime;
+		if (!Direction.IsNearlyZero())
+		{
+			Yaws[i] = Direction.Rotation().Yaw;
+		}
+	}
+}
+
+void UEnemyCrowdSubsystem::PromoteRows(const FVector& PlayerLocation)
+{
+	const float PromoteDistanceSq = PromoteDistance * PromoteDistance;
+	for (int32 i = Positions.Num() - 1; i >= 0; i--)
+	{
+		if (ConversionsThisFrame >= MaxConversionsPerFrame || Promoted.Num() >= MaxPromotedActors)
+		{
+			return;
+		}
+		if (FVector::DistSquared(Positions[i], PlayerLocation) >= PromoteDistanceSq)
+		{
+			continue;
+		}
+
+		//Rows move in straight lines where the field doesn't reach, don't put an actor inside a wall
+		FVector Location = Positions[i];
+		if (!ProjectToNavMesh(RowArchetypes[i], Location))
+		{
+			continue;
+		}
+
+		if (SpawnPromoted(RowArchetypes[i], Location, FRotator(0.f, Yaws[i], 0.f), Rooms[i].Get(), Healths[i], RowWeapons[i]))
+		{
+			RemoveRow(i);
+			ConversionsThisFrame++;
+			INC_DWORD_STAT(STAT_CrowdPromotions);
+		}
+	}
+}
+
+void UEnemyCrowdSubsystem::DemoteEnemies(const FVector& PlayerLocation)
+{
+	const float DemoteDistanceSq = DemoteDistance * DemoteDistance;
+	for (int32 i = Promoted.Num() - 1; i >= 0; i--)
+	{
+		AAICharacter* Enemy = Promoted[i].Enemy.Get();
+		if (!Enemy || Enemy->IsPendingKill() || Enemy->IsDead())
+		{
+			Promoted.RemoveAtSwap(i, 1, false);
+			continue;
+		}
+
+		//Enemies in a fight or without a mesh to draw them as rows always stay actors
+		if (ConversionsThisFrame >= MaxConversionsPerFrame || Enemy->bEngaged || !Archetypes[Promoted[i].Archetype].Instances)
+		{
+			continue;
+		}
+		const FVector Location = Enemy->GetActorLocation();
+		if (FVector::DistSquared(Location, PlayerLocation) <= DemoteDistanceSq)
+		{
+			continue;
+		}
+
+		AddRow(Promoted[i].Archetype, Location, Enemy->GetActorRotation().Yaw, Enemy->GetOwner(), Enemy->CurrentHealth, Enemy->CurrentWeapon);
+		Promoted.RemoveAtSwap(i, 1, false);
+		if (UEnemyPoolSubsystem* Pool = GetWorld()->GetSubsystem<UEnemyPoolSubsystem>())
+		{
+			Pool->ReleaseEnemy(Enemy);
+		}
+		else
+		{
+			Enemy->Destroy();
+		}
+		ConversionsThisFrame++;
+		INC_DWORD_STAT(STAT_CrowdDemotions);
+	}
+}
+
+void UEnemyCrowdSubsystem::UpdateInstances()
+{
+	SCOPE_CYCLE_COUNTER(STAT_CrowdInstances);
+
+	for (int32 a = 0; a < Archetypes.Num(); a++)
+	{
+		UInstancedStaticMeshComponent* Instances = Archetypes[a].Instances;
+		if (!Instances)
+		{
+			continue;
+		}
+
+		const FVector MeshOffset(0.f, 0.f, -Archetypes[a].HalfHeight);
+		InstanceTransforms.Reset();
+		for (int32 i = 0; i < Positions.Num(); i++)
+		{
+			if (RowArchetypes[i] == a)
+			{
+				InstanceTransforms.Emplace(FRotator(0.f, Yaws[i], 0.f), Positions[i] + MeshOffset);
+			}
+		}
+
+		//Only add or remove instances at the end, everything else is one batched update
+		const int32 Num = InstanceTransforms.Num();
+		while (Instances->GetInstanceCount() > Num)
+		{
+			Instances->RemoveInstance(Instances->GetInstanceCount() - 1);
+		}
+		while (Instances->GetInstanceCount() < Num)
+		{
+			Instances->AddInstance(FTransform::Identity);
+		}
+		if (Num > 0)
+		{
+			Instances->BatchUpdateInstancesTransforms(0, InstanceTransforms, true, true, true);
+		}
+	}
+}
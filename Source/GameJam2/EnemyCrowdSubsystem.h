@@ -0,0 +1,130 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "EnemyCrowdSubsystem.generated.h"
+
+class AAICharacter;
+class UInstancedStaticMeshComponent;
+
+//One enemy class as seen by the crowd, with the instances that draw its rows
+USTRUCT()
+struct FEnemyArchetype
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	UClass* EnemyClass = nullptr;
+
+	UPROPERTY()
+	UInstancedStaticMeshComponent* Instances = nullptr;
+
+	float Speed = 0.f;
+
+	//Rows are stored at the capsule centre, the mesh is drawn this far below
+	float HalfHeight = 0.f;
+};
+
+//An actor the crowd spawned, which it may turn back into a row
+struct FPromotedEnemy
+{
+	TWeakObjectPtr<AAICharacter> Enemy;
+	int32 Archetype;
+};
+
+/**
+ * Keeps enemies far from the player as rows in flat arrays instead of actors.
+ * Rows walk towards the player in bulk once the player is in their room or close, and are drawn with one
+ * instanced mesh per enemy class. Rows near the player are promoted to real AAICharacters, and promoted
+ * enemies that end up far away and out of a fight are demoted back into rows. Actors come from the enemy pool.
+ */
+UCLASS(config = Game)
+class GAMEJAM2_API UEnemyCrowdSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End FTickableGameObject interface
+
+	//Spawn an enemy, as an actor if the player is close and as a row otherwise.
+	//Health <= 0 and Weapon < 0 keep the class defaults
+	void SpawnEnemy(UClass* EnemyClass, const FVector& Location, const FRotator& Rotation, AActor* Room, int32 Health = 0, int32 Weapon = -1);
+
+	int32 GetNumRows() const { return Positions.Num(); }
+	int32 GetNumPromoted() const { return Promoted.Num(); }
+
+	//Rows closer than this to the player become actors
+	UPROPERTY(Config)
+	float PromoteDistance = 3000.f;
+
+	//Promoted enemies further than this (and not fighting) become rows again
+	UPROPERTY(Config)
+	float DemoteDistance = 4500.f;
+
+	//Rows within this distance of the player chase them even outside the player's room
+	UPROPERTY(Config)
+	float ChaseDistance = 6000.f;
+
+	//Never have more crowd spawned actors than this alive at once
+	UPROPERTY(Config)
+	int32 MaxPromotedActors = 64;
+
+	//How far from a row's position a promoted actor may be placed to land on the nav mesh
+	UPROPERTY(Config)
+	float PromoteProjectionRadius = 300.f;
+
+	//Actors spawned or destroyed by the crowd per frame
+	UPROPERTY(Config)
+	int32 MaxConversionsPerFrame = 4;
+
+private:
+	int32 FindOrAddArchetype(UClass* EnemyClass);
+
+	AAICharacter* SpawnPromoted(int32 Archetype, const FVector& Location, const FRotator& Rotation, AActor* Room, int32 Health, int32 Weapon);
+
+	//Move the location onto the nav mesh at the archetype's capsule height, false if there is none nearby
+	bool ProjectToNavMesh(int32 Archetype, FVector& InOutLocation) const;
+
+	void AddRow(int32 Archetype, const FVector& Location, float Yaw, AActor* Room, int32 Health, int32 Weapon);
+
+	void RemoveRow(int32 Index);
+
+	void SimulateRows(float DeltaTime, const FVector& PlayerLocation);
+
+	void PromoteRows(const FVector& PlayerLocation);
+
+	void DemoteEnemies(const FVector& PlayerLocation);
+
+	void UpdateInstances();
+
+	UPROPERTY()
+	TArray<FEnemyArchetype> Archetypes;
+
+	UPROPERTY()
+	AActor* InstancesActor;
+
+	// Structure of arrays, index i in each is the same row
+	TArray<FVector> Positions;
+	TArray<FVector> Velocities;
+	TArray<float> Yaws;
+	TArray<int32> Healths;
+	TArray<int8> RowWeapons;
+	TArray<uint16> RowArchetypes;
+	TArray<TWeakObjectPtr<AActor>> Rooms;
+
+	TArray<FPromotedEnemy> Promoted;
+
+	int32 ConversionsThisFrame = 0;
+
+	//Per frame scratch, instance transforms for one archetype
+	TArray<FTransform> InstanceTransforms;
+};
@@ -0,0 +1,208 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "EnemyMovementComponent.h"
+#include "GameJam2.h"
+#include "PawnPerceptionSubsystem.h"
+#include "GameFramework/Character.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Enemy Move Nav Walking"), STAT_EnemyMoveNavWalking, STATGROUP_GameJam2);
+DECLARE_CYCLE_STAT(TEXT("Enemy Move Full Sweep"), STAT_EnemyMoveSweep, STATGROUP_GameJam2);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Enemy Mode Switches"), STAT_EnemyModeSwitches, STATGROUP_GameJam2);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Enemy Depenetrations"), STAT_EnemyDepenetrations, STATGROUP_GameJam2);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Enemy Overlap Pushes"), STAT_EnemyOverlapPushes, STATGROUP_GameJam2);
+
+static TAutoConsoleVariable<int32> CVarEnemyMovementMode(
+	TEXT("GameJam2.EnemyMovementMode"),
+	0,
+	TEXT("0: switch automatically, 1: always nav walk, 2: always full sweeps. For comparing costs"));
+
+//Cycles and ticks per mode since the last benchmark report, 0 is nav walking and 1 full sweeps
+static uint64 GEnemyMoveCycles[2] = { 0, 0 };
+static uint32 GEnemyMoveTicks[2] = { 0, 0 };
+
+//Depenetration work since the last reset
+static uint32 GEnemyDepenetrations = 0;
+static uint64 GEnemyDepenetrationCycles = 0;
+static uint32 GEnemyOverlapPushes = 0;
+
+//Logs the average cost of one enemy movement tick in each mode and starts a new sample
+static FAutoConsoleCommand GMovementBenchmarkCommand(
+	TEXT("GameJam2.MovementBenchmark"),
+	TEXT("Log the average per-enemy movement tick cost for nav walking and full sweeps since the last call"),
+	FConsoleCommandDelegate::CreateStatic([]()
+	{
+		for (int32 Mode = 0; Mode < 2; Mode++)
+		{
+			const double Microseconds = FPlatformTime::ToMilliseconds64(GEnemyMoveCycles[Mode]) * 1000.0;
+			UE_LOG(LogGameJam2, Display, TEXT("Enemy movement %s: %u ticks, %.2f us per tick"),
+				Mode == 0 ? TEXT("nav walking") : TEXT("full sweeps"), GEnemyMoveTicks[Mode],
+				GEnemyMoveTicks[Mode] > 0 ? Microseconds / GEnemyMoveTicks[Mode] : 0.0);
+			GEnemyMoveCycles[Mode] = 0;
+			GEnemyMoveTicks[Mode] = 0;
+		}
+	}));
+
+void UEnemyMovementComponent::ResetDepenetrationStats()
+{
+	GEnemyDepenetrations = 0;
+	GEnemyDepenetrationCycles = 0;
+	GEnemyOverlapPushes = 0;
+}
+
+void UEnemyMovementComponent::GetDepenetrationStats(uint32& OutResolves, double& OutMilliseconds, uint32& OutOverlapPushes)
+{
+	OutResolves = GEnemyDepenetrations;
+	OutMilliseconds = FPlatformTime::ToMilliseconds64(GEnemyDepenetrationCycles);
+	OutOverlapPushes = GEnemyOverlapPushes;
+}
+
+UEnemyMovementComponent::UEnemyMovementComponent()
+{
+	//Nav walking by default, without sweeping and staying stuck to the nav mesh
+	DefaultLandMovementMode = MOVE_NavWalking;
+	bSweepWhileNavWalking = false;
+	bProjectNavMeshWalking = true;
+	NavMeshProjectionInterval = 0.1f;
+
+	ObstacleChannels.Add(ECC_WorldDynamic);
+	ObstacleChannels.Add(ECC_PhysicsBody);
+}
+
+void UEnemyMovementComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+	if (Now >= NextObstacleCheckTime)
+	{
+		NextObstacleCheckTime = Now + ObstacleCheckInterval;
+		UpdateMovementMode();
+	}
+
+	const int32 Mode = IsUsingCheapMovement() ? 0 : 1;
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	{
+		CONDITIONAL_SCOPE_CYCLE_COUNTER(STAT_EnemyMoveNavWalking, Mode == 0);
+		CONDITIONAL_SCOPE_CYCLE_COUNTER(STAT_EnemyMoveSweep, Mode == 1);
+		Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	}
+	GEnemyMoveCycles[Mode] += FPlatformTime::Cycles64() - StartCycles;
+	GEnemyMoveTicks[Mode]++;
+}
+
+bool UEnemyMovementComponent::ResolvePenetrationImpl(const FVector& Adjustment, const FHitResult& Hit, const FQuat& NewRotation)
+{
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	const bool bResolved = Super::ResolvePenetrationImpl(Adjustment, Hit, NewRotation);
+	GEnemyDepenetrationCycles += FPlatformTime::Cycles64() - StartCycles;
+	GEnemyDepenetrations++;
+	INC_DWORD_STAT(STAT_EnemyDepenetrations);
+	return bResolved;
+}
+
+void UEnemyMovementComponent::SetNavWalkingPhysics(bool bEnable)
+{
+	Super::SetNavWalkingPhysics(bEnable);
+
+	//Nav walking sets the capsule to ignore WorldDynamic, which bullets are, so put back what the blueprint had
+	if (bEnable && UpdatedPrimitive && CharacterOwner && CharacterOwner->GetCapsuleComponent() == UpdatedComponent)
+	{
+		const ACharacter* Defaults = CharacterOwner->GetClass()->GetDefaultObject<ACharacter>();
+		UpdatedPrimitive->SetCollisionResponseToChannel(ECC_WorldDynamic, Defaults->GetCapsuleComponent()->GetCollisionResponseToChannel(ECC_WorldDynamic));
+	}
+}
+
+void UEnemyMovementComponent::UpdateMovementMode()
+{
+	//Leave falling, flying and so on alone
+	if (MovementMode != MOVE_Walking && MovementMode != MOVE_NavWalking)
+	{
+		return;
+	}
+
+	bool bNearObstacle = false;
+	const int32 ForcedMode = CVarEnemyMovementMode.GetValueOnGameThread();
+	if (ForcedMode == 0)
+	{
+		FCollisionObjectQueryParams ObjectParams;
+		for (ECollisionChannel Channel : ObstacleChannels)
+		{
+			ObjectParams.AddObjectTypesToQuery(Channel);
+		}
+		FCollisionQueryParams Params(SCENE_QUERY_STAT(EnemyObstacleCheck), false, GetOwner());
+		bNearObstacle = GetWorld()->OverlapAnyTestByObjectType(UpdatedComponent->GetComponentLocation(), FQuat::Identity, ObjectParams, FCollisionShape::MakeSphere(ObstacleCheckRadius), Params);
+	}
+	else
+	{
+		bNearObstacle = ForcedMode == 2;
+	}
+
+	const EMovementMode WantedMode = bNearObstacle ? MOVE_Walking : MOVE_NavWalking;
+	if (MovementMode != WantedMode)
+	{
+		SetMovementMode(WantedMode);
+		INC_DWORD_STAT(STAT_EnemyModeSwitches);
+	}
+}
+
+void UEnemyMovementComponent::UpdateSeparation()
+{
+	Separation = FVector::ZeroVector;
+	const UPawnPerceptionSubsystem* Perception = GetWorld()->GetSubsystem<UPawnPerceptionSubsystem>();
+	if (!Perception)
+	{
+		return;
+	}
+
+	//Neighbours come from the perception's spatial hash, no collision queries
+	const FVector Location = UpdatedComponent->GetComponentLocation();
+	const float OverlapDistance = PawnOwner->GetSimpleCollisionRadius() * 2.f;
+	bool bOverlapping = false;
+	Neighbours.Reset();
+	Perception->GetPawnsInRadius(Location, SeparationRadius, Neighbours);
+	for (APawn* Neighbour : Neighbours)
+	{
+		if (Neighbour == PawnOwner)
+		{
+			continue;
+		}
+		const FVector Away = Location - Neighbour->GetActorLocation();
+		const float Distance = Away.Size2D();
+		if (Distance > KINDA_SMALL_NUMBER)
+		{
+			Separation += Away.GetSafeNormal2D() * (1.f - Distance / SeparationRadius);
+		}
+		bOverlapping |= Distance < OverlapDistance;
+	}
+	if (bOverlapping)
+	{
+		GEnemyOverlapPushes++;
+		INC_DWORD_STAT(STAT_EnemyOverlapPushes);
+	}
+	Separation = Separation.GetClampedToMaxSize(1.f);
+}
+
+void UEnemyMovementComponent::CalcVelocity(float DeltaTime, float Friction, bool bFluid, float BrakingDeceleration)
+{
+	Super::CalcVelocity(DeltaTime, Friction, bFluid, BrakingDeceleration);
+
+	//Nav walking doesn't collide with other pawns, so keep them apart by steering instead
+	if (!IsUsingCheapMovement() || SeparationStrength <= 0.f)
+	{
+		return;
+	}
+
+	const float Now = GetWorld()->GetTimeSeconds();
+	if (Now >= NextSeparationTime)
+	{
+		NextSeparationTime = Now + SeparationInterval;
+		UpdateSeparation();
+	}
+
+	if (!Separation.IsZero())
+	{
+		const float MaxSpeed = GetMaxSpeed();
+		Velocity = (Velocity + Separation * MaxSpeed * SeparationStrength).GetClampedToMaxSize(MaxSpeed);
+	}
+}
@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "EnemyMovementComponent.generated.h"
+
+/**
+ * Character movement for enemies. Out in the open they nav walk, sliding along the nav mesh without
+ * collision sweeps and pushing apart from nearby pawns. Near dynamic obstacles (doors, physics props)
+ * they switch to normal walking with full sweeps, and back again once clear.
+ */
+UCLASS()
+class GAMEJAM2_API UEnemyMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+public:
+	UEnemyMovementComponent();
+
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	virtual void CalcVelocity(float DeltaTime, float Friction, bool bFluid, float BrakingDeceleration) override;
+
+	//True while nav walking instead of sweeping
+	bool IsUsingCheapMovement() const { return MovementMode == MOVE_NavWalking; }
+
+	//Work spent pushing overlapping enemies apart since the last reset: collision depenetrations, the time they
+	//took, and separation updates that found an overlapping neighbour
+	static void ResetDepenetrationStats();
+	static void GetDepenetrationStats(uint32& OutResolves, double& OutMilliseconds, uint32& OutOverlapPushes);
+
+	//Seconds between checks for dynamic obstacles nearby
+	UPROPERTY(EditAnywhere, Category = "Enemy Movement")
+	float ObstacleCheckInterval = 0.25f;
+
+	//Anything of ObstacleChannels within this radius switches to full sweeps
+	UPROPERTY(EditAnywhere, Category = "Enemy Movement")
+	float ObstacleCheckRadius = 300.f;
+
+	//Object types that count as dynamic obstacles
+	UPROPERTY(EditAnywhere, Category = "Enemy Movement")
+	TArray<TEnumAsByte<ECollisionChannel>> ObstacleChannels;
+
+	//Pawns closer than this push each other apart while nav walking
+	UPROPERTY(EditAnywhere, Category = "Enemy Movement")
+	float SeparationRadius = 120.f;
+
+	//How hard they push, as a fraction of max speed
+	UPROPERTY(EditAnywhere, Category = "Enemy Movement")
+	float SeparationStrength = 0.5f;
+
+	//Seconds between working out the separation push
+	UPROPERTY(EditAnywhere, Category = "Enemy Movement")
+	float SeparationInterval = 0.1f;
+
+protected:
+	virtual bool ResolvePenetrationImpl(const FVector& Adjustment, const FHitResult& Hit, const FQuat& NewRotation) override;
+
+	virtual void SetNavWalkingPhysics(bool bEnable) override;
+
+private:
+	void UpdateMovementMode();
+
+	void UpdateSeparation();
+
+	float NextObstacleCheckTime = 0.f;
+
+	float NextSeparationTime = 0.f;
+
+	FVector Separation = FVector::ZeroVector;
+
+	TArray<APawn*> Neighbours;
+};
@@ -0,0 +1,176 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "EnemyPoolSubsystem.h"
+#include "GameJam2.h"
+#include "AICharacter.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Enemy Pool Acquire"), STAT_EnemyPoolAcquire, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemy Pool Hits"), STAT_EnemyPoolHits, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemy Pool Misses"), STAT_EnemyPoolMisses, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemy Pool Overflows"), STAT_EnemyPoolOverflows, STATGROUP_GameJam2);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pooled Enemies"), STAT_PooledEnemies, STATGROUP_GameJam2);
+
+static FAutoConsoleCommandWithWorld GEnemyPoolStatsCommand(
+	TEXT("GameJam2.EnemyPoolStats"),
+	TEXT("Log enemy pool hits, misses and dormant enemies"),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		if (UEnemyPoolSubsystem* Pool = World ? World->GetSubsystem<UEnemyPoolSubsystem>() : nullptr)
+		{
+			UE_LOG(LogGameJam2, Display, TEXT("Enemy pool: %d hits, %d misses, %d overflows, %d releases, %d dormant"),
+				Pool->PoolHits, Pool->PoolMisses, Pool->PoolOverflows, Pool->Releases, Pool->GetNumDormant());
+		}
+	}));
+
+void UEnemyPoolSubsystem::Deinitialize()
+{
+	for (auto& Pair : Pools)
+	{
+		DEC_DWORD_STAT_BY(STAT_PooledEnemies, Pair.Value.AllEnemies.Num());
+	}
+	Pools.Empty();
+	Super::Deinitialize();
+}
+
+int32 UEnemyPoolSubsystem::GetNumDormant() const
+{
+	int32 Dormant = 0;
+	for (const auto& Pair : Pools)
+	{
+		Dormant += Pair.Value.DormantEnemies.Num();
+	}
+	return Dormant;
+}
+
+void UEnemyPoolSubsystem::PrewarmPool(UClass* EnemyClass, int32 Count)
+{
+	if (!EnemyClass || !EnemyClass->IsChildOf(AAICharacter::StaticClass()) || Count <= 0)
+	{
+		return;
+	}
+
+	FEnemyPool& Pool = Pools.FindOrAdd(EnemyClass);
+	Pool.Reserved += Count;
+	const int32 Target = FMath::Min3(Pool.Reserved, MaxPrewarmPerClass, HighWaterMark);
+	PruneDestroyed(Pool);
+	while (Pool.AllEnemies.Num() < Target)
+	{
+		AAICharacter* Enemy = SpawnPooledEnemy(EnemyClass, Pool);
+		if (!Enemy)
+		{
+			break;
+		}
+		Pool.DormantEnemies.Add(Enemy);
+	}
+}
+
+AAICharacter* UEnemyPoolSubsystem::AcquireEnemy(UClass* EnemyClass, const FVector& Location, const FRotator& Rotation, AActor* Room, int32 Health, int32 Weapon)
+{
+	SCOPE_CYCLE_COUNTER(STAT_EnemyPoolAcquire);
+
+	UWorld* World = GetWorld();
+	if (!EnemyClass || !World || !EnemyClass->IsChildOf(AAICharacter::StaticClass()))
+	{
+		return nullptr;
+	}
+
+	FEnemyPool& Pool = Pools.FindOrAdd(EnemyClass);
+	AAICharacter* Enemy = nullptr;
+
+	//Dormant enemies can be destroyed from outside (level unload, blueprint calling DestroyActor)
+	while (!Enemy && Pool.DormantEnemies.Num() > 0)
+	{
+		Enemy = Pool.DormantEnemies.Pop(false);
+		if (!IsValid(Enemy))
+		{
+			Enemy = nullptr;
+		}
+	}
+
+	if (Enemy)
+	{
+		PoolHits++;
+		INC_DWORD_STAT(STAT_EnemyPoolHits);
+	}
+	else if (PruneDestroyed(Pool) < HighWaterMark)
+	{
+		PoolMisses++;
+		INC_DWORD_STAT(STAT_EnemyPoolMisses);
+		Enemy = SpawnPooledEnemy(EnemyClass, Pool);
+	}
+	else
+	{
+		//Pool is full, spawn a one off enemy that is destroyed when it is done with
+		PoolOverflows++;
+		INC_DWORD_STAT(STAT_EnemyPoolOverflows);
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.Owner = Room;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		Enemy = World->SpawnActor<AAICharacter>(EnemyClass, Location, Rotation, SpawnParams);
+		if (Enemy)
+		{
+			Enemy->InjectStats(Health, Weapon);
+		}
+		return Enemy;
+	}
+
+	if (Enemy)
+	{
+		//The room owns the enemy for squads and the wave director, so set it before the enemy rejoins the AI
+		Enemy->SetOwner(Room);
+		Enemy->SetActorLocationAndRotation(Location, Rotation, false, nullptr, ETeleportType::TeleportPhysics);
+		Enemy->ActivateEnemy(Health, Weapon);
+	}
+	return Enemy;
+}
+
+void UEnemyPoolSubsystem::ReleaseEnemy(AAICharacter* Enemy)
+{
+	if (!Enemy || Enemy->IsDormant())
+	{
+		return;
+	}
+
+	FEnemyPool* Pool = Enemy->OwningPool.Get() == this ? Pools.Find(Enemy->GetClass()) : nullptr;
+	if (!Pool)
+	{
+		Enemy->Destroy();
+		return;
+	}
+
+	Releases++;
+	Enemy->DeactivateEnemy();
+	Pool->DormantEnemies.Add(Enemy);
+}
+
+int32 UEnemyPoolSubsystem::PruneDestroyed(FEnemyPool& Pool)
+{
+	//Active enemies destroyed from outside never come back through the dormant list, so drop them here or they hold their place forever
+	const int32 Removed = Pool.AllEnemies.RemoveAllSwap([](AAICharacter* Enemy) { return !IsValid(Enemy); }, false);
+	DEC_DWORD_STAT_BY(STAT_PooledEnemies, Removed);
+	return Pool.AllEnemies.Num();
+}
+
+AAICharacter* UEnemyPoolSubsystem::SpawnPooledEnemy(UClass* EnemyClass, FEnemyPool& Pool)
+{
+	//Deferred so the enemy knows it is pooled before BeginPlay, and stays out of the AI systems while dormant
+	AAICharacter* Enemy = GetWorld()->SpawnActorDeferred<AAICharacter>(EnemyClass, FTransform::Identity, nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+	if (!Enemy)
+	{
+		return nullptr;
+	}
+	Enemy->OwningPool = this;
+	Enemy->FinishSpawning(FTransform::Identity);
+
+	//Possess now so the controller, blackboard and behaviour tree are all set up before the enemy is needed
+	if (!Enemy->GetController())
+	{
+		Enemy->SpawnDefaultController();
+	}
+	Enemy->DeactivateEnemy();
+	Pool.AllEnemies.Add(Enemy);
+	INC_DWORD_STAT(STAT_PooledEnemies);
+	return Enemy;
+}
@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "EnemyPoolSubsystem.generated.h"
+
+class AAICharacter;
+
+//All the enemies of one class
+USTRUCT()
+struct FEnemyPool
+{
+	GENERATED_BODY()
+
+	//Every enemy this pool owns, active or not
+	UPROPERTY()
+	TArray<AAICharacter*> AllEnemies;
+
+	//Possessed, paused enemies ready to be handed out
+	UPROPERTY()
+	TArray<AAICharacter*> DormantEnemies;
+
+	//Enemies asked for by the spawners' schedules
+	int32 Reserved = 0;
+};
+
+/**
+ * Hands out enemies for the spawners and the crowd, recycling them instead of spawning and destroying an actor per enemy.
+ * Enemies are spawned during level load already possessed with their behaviour tree started and paused, so activating
+ * one is only a teleport, a stat reset and a resume. Dead enemies come back here once their corpse is removed.
+ */
+UCLASS(config = Game)
+class GAMEJAM2_API UEnemyPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	//Reserve Count more enemies of this class and spawn dormant ones up to the reservation (capped at MaxPrewarmPerClass)
+	void PrewarmPool(UClass* EnemyClass, int32 Count);
+
+	//Wake an enemy of the given class at the given transform, owned by Room.
+	//Health <= 0 keeps the class default, Weapon < 0 keeps the class default weapon
+	AAICharacter* AcquireEnemy(UClass* EnemyClass, const FVector& Location, const FRotator& Rotation, AActor* Room, int32 Health = 0, int32 Weapon = -1);
+
+	//Put an enemy back to sleep. Enemies the pool didn't spawn are destroyed
+	void ReleaseEnemy(AAICharacter* Enemy);
+
+	//Most enemies of one class spawned at level load
+	UPROPERTY(Config)
+	int32 MaxPrewarmPerClass = 16;
+
+	//Maximum number of enemies a single class pool may own, enemies over this are spawned unpooled
+	UPROPERTY(Config)
+	int32 HighWaterMark = 64;
+
+	//Enemies served from a dormant enemy
+	int32 PoolHits = 0;
+	//Enemies that had to spawn a new pooled enemy mid game
+	int32 PoolMisses = 0;
+	//Enemies that went over the high-water mark
+	int32 PoolOverflows = 0;
+	//Enemies put back to sleep
+	int32 Releases = 0;
+
+	int32 GetNumDormant() const;
+
+private:
+	AAICharacter* SpawnPooledEnemy(UClass* EnemyClass, FEnemyPool& Pool);
+
+	//Forget enemies destroyed from outside the pool, returns how many are left
+	int32 PruneDestroyed(FEnemyPool& Pool);
+
+	UPROPERTY()
+	TMap<UClass*, FEnemyPool> Pools;
+};
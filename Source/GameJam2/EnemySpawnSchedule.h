@@ -0,0 +1,43 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/SoftObjectPtr.h"
+#include "EnemySpawnSchedule.generated.h"
+
+class AActor;
+
+/**
+ * One enemy type in a spawner's schedule. Once the player enters the room the first enemy spawns after
+ * InitialDelay, then another every RepeatInterval until RepeatCount more have spawned.
+ */
+USTRUCT(BlueprintType)
+struct FEnemySpawnEntry
+{
+	GENERATED_BODY()
+
+	//Loaded in the background by the asset preloader when the room starts
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Spawning)
+	TSoftClassPtr<AActor> EnemyClass;
+
+	//Seconds after the room is entered before the first spawn
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Spawning)
+	float InitialDelay = 0.f;
+
+	//Seconds between repeat spawns
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Spawning)
+	float RepeatInterval = 1.f;
+
+	//Spawns after the first one
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Spawning)
+	int32 RepeatCount = 0;
+
+	//Starting health, 0 keeps the enemy's default
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Spawning)
+	int32 Health = 0;
+
+	//Index into the enemy's Weapons, -1 keeps the enemy's default weapon
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Spawning)
+	int32 Weapon = -1;
+};
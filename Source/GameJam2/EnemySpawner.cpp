@@ -2,12 +2,112 @@
 
 
 #include "EnemySpawner.h"
+#include "AISignificanceSubsystem.h"
+#include "EnemyCrowdSubsystem.h"
+#include "EnemyPoolSubsystem.h"
+#include "SpawnQueueSubsystem.h"
+#include "RoomStreamingSubsystem.h"
+#include "AssetPreloadSubsystem.h"
+#include "WaveDirectorSubsystem.h"
+#include "AICharacter.h"
+#include "EnemyMovementComponent.h"
+#include "GameJam2.h"
+#include "EngineUtils.h"
+#include "TimerManager.h"
+#include "Kismet/GameplayStatics.h"
+
+//Spawns a batch of enemies at the spawner nearest the player, then logs how much pushing apart they needed
+static FAutoConsoleCommandWithWorldAndArgs GSpawnSlotBenchmarkCommand(
+	TEXT("GameJam2.SpawnSlotBenchmark"),
+	TEXT("GameJam2.SpawnSlotBenchmark [Count=100] [UseSlots=1]. Spawn Count enemies in the nearest room at once and log the depenetration work over the next 3 seconds"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		const int32 Count = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 100;
+		const bool bUseSlots = Args.Num() > 1 ? FCString::Atoi(*Args[1]) != 0 : true;
+		UEnemyPoolSubsystem* Pool = World ? World->GetSubsystem<UEnemyPoolSubsystem>() : nullptr;
+		APawn* Player = UGameplayStatics::GetPlayerPawn(World, 0);
+		if (!Pool || !Player)
+		{
+			return;
+		}
+
+		AEnemySpawner* Spawner = nullptr;
+		UClass* EnemyClass = nullptr;
+		float BestDistanceSq = MAX_flt;
+		for (TActorIterator<AEnemySpawner> It(World); It; ++It)
+		{
+			for (const FEnemySpawnEntry& Entry : It->GetSpawnSchedule())
+			{
+				const float DistanceSq = FVector::DistSquared(It->GetActorLocation(), Player->GetActorLocation());
+				UClass* EntryClass = Entry.EnemyClass.LoadSynchronous();
+				if (EntryClass && EntryClass->IsChildOf(AAICharacter::StaticClass()) && DistanceSq < BestDistanceSq)
+				{
+					Spawner = *It;
+					EnemyClass = EntryClass;
+					BestDistanceSq = DistanceSq;
+				}
+			}
+		}
+		if (!Spawner)
+		{
+			UE_LOG(LogGameJam2, Warning, TEXT("Spawn slot benchmark: no spawner with an AI enemy"));
+			return;
+		}
+
+		UEnemyMovementComponent::ResetDepenetrationStats();
+		const double StartTime = FPlatformTime::Seconds();
+		TArray<TWeakObjectPtr<AAICharacter>> Spawned;
+		for (int32 i = 0; i < Count; i++)
+		{
+			Spawned.Add(Pool->AcquireEnemy(EnemyClass, Spawner->ClaimSpawnLocation(bUseSlots), Spawner->GetActorRotation(), Spawner));
+		}
+		const double SpawnMilliseconds = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+		FTimerHandle ReportHandle;
+		World->GetTimerManager().SetTimer(ReportHandle, FTimerDelegate::CreateLambda([Spawned, Pool, bUseSlots, SpawnMilliseconds]()
+		{
+			uint32 Resolves, OverlapPushes;
+			double ResolveMilliseconds;
+			UEnemyMovementComponent::GetDepenetrationStats(Resolves, ResolveMilliseconds, OverlapPushes);
+
+			//Enemies still inside each other after the settle time
+			int32 StillOverlapping = 0;
+			for (int32 i = 0; i < Spawned.Num(); i++)
+			{
+				AAICharacter* Enemy = Spawned[i].Get();
+				if (!Enemy)
+				{
+					continue;
+				}
+				const float Radius = Enemy->GetSimpleCollisionRadius();
+				for (int32 j = i + 1; j < Spawned.Num(); j++)
+				{
+					AAICharacter* Other = Spawned[j].Get();
+					if (Other && FVector::DistSquared2D(Enemy->GetActorLocation(), Other->GetActorLocation()) < FMath::Square(Radius + Other->GetSimpleCollisionRadius()))
+					{
+						StillOverlapping++;
+					}
+				}
+			}
+
+			UE_LOG(LogGameJam2, Display, TEXT("Spawn slot benchmark (%s): %d enemies spawned in %.2f ms, %u depenetrations taking %.3f ms, %u overlap pushes, %d pairs still overlapping"),
+				bUseSlots ? TEXT("slots") : TEXT("stacked"), Spawned.Num(), SpawnMilliseconds, Resolves, ResolveMilliseconds, OverlapPushes, StillOverlapping);
+
+			for (const TWeakObjectPtr<AAICharacter>& Enemy : Spawned)
+			{
+				if (Enemy.IsValid() && Pool)
+				{
+					Pool->ReleaseEnemy(Enemy.Get());
+				}
+			}
+		}), 3.f, false);
+	}));
 
 // Sets default values
 AEnemySpawner::AEnemySpawner()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+ 	// Spawns are scheduled by the wave director, the spawner never needs to tick
+	PrimaryActorTick.bCanEverTick = false;
 
 	//Register OnBeginOverlap function as an OnActorBeginOverlap delegate
 	OnActorBeginOverlap.AddDynamic(this, &AEnemySpawner::OnBeginOverlap);
@@ -26,72 +126,132 @@ AEnemySpawner::AEnemySpawner()
 void AEnemySpawner::BeginPlay()
 {
 	Super::BeginPlay();
-	bStartRepeatSpawn = false;
+
+	//Rooms set up with the old single enemy fields become one entry of the schedule.
+	//The old state machine spent a second counting before it armed the first spawn, so that is kept
+	if (!Enemy1.IsNull())
+	{
+		FEnemySpawnEntry& Entry = SpawnSchedule.AddDefaulted_GetRef();
+		Entry.EnemyClass = Enemy1;
+		Entry.InitialDelay = 1.f + TimeBeforeInitialSpawnEnemy1;
+		Entry.RepeatInterval = IntervalBetweenRepeatSpawnsEnemy1;
+		Entry.RepeatCount = bRepeatSpawnEnemy1 ? FMath::Max(NumberOfRepeatsEnemy1, 0) : 0;
+		Entry.Health = Enemy1Health;
+		Entry.Weapon = Enemy1weapon;
+	}
+
+	SpawnSlots.HoldSeconds = SpawnSlotHoldSeconds;
+	BuildSpawnSlots();
+
+	if (URoomStreamingSubsystem* RoomStreaming = GetWorld()->GetSubsystem<URoomStreamingSubsystem>())
+	{
+		RoomStreaming->RegisterRoom(this, RoomLevel);
+	}
+
+	//Load this room's enemy classes in the background, the pool is filled once they are in
+	if (UAssetPreloadSubsystem* Preloader = GetWorld()->GetSubsystem<UAssetPreloadSubsystem>())
+	{
+		Preloader->PreloadRoom(this, FStreamableDelegate::CreateUObject(this, &AEnemySpawner::PrewarmEnemies));
+	}
+	else
+	{
+		PrewarmEnemies();
+	}
 }
 
-void AEnemySpawner::ResetCounterTimer()
+void AEnemySpawner::PrewarmEnemies()
 {
-	SecondsAfterStart++;
-	bCountTimerOnCooldown = false;
-	bStartRepeatSpawn = true;
-	GetWorldTimerManager().ClearTimer(CounterTimeHandle);
+	//Spawn this room's enemies now, around level load, so they only need waking up when the wave comes
+	if (UEnemyPoolSubsystem* Pool = GetWorld()->GetSubsystem<UEnemyPoolSubsystem>())
+	{
+		for (const FEnemySpawnEntry& Entry : SpawnSchedule)
+		{
+			Pool->PrewarmPool(Entry.EnemyClass.Get(), 1 + FMath::Max(Entry.RepeatCount, 0));
+		}
+	}
 }
 
-void AEnemySpawner::ResetTimeBeforeSpawnEnemy1Timer()
+void AEnemySpawner::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	bSpawnOnCooldown = false;
-	GetWorldTimerManager().ClearTimer(TimeBeforeSpawnEnemy1Handle);
-	UWorld* World = GetWorld();
-	FActorSpawnParameters SpawnParams;
-	SpawnParams.Owner = this;
-	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
-	UClass* GeneratedBPEnemy = Cast<UClass>(Enemy1);
-	World->SpawnActor<AActor>(GeneratedBPEnemy, this->GetActorLocation(), this->GetActorRotation(), SpawnParams);
-	bStartRepeatSpawn = true;
+	if (UWaveDirectorSubsystem* WaveDirector = GetWorld()->GetSubsystem<UWaveDirectorSubsystem>())
+	{
+		WaveDirector->StopSchedule(this);
+	}
+	if (USpawnQueueSubsystem* SpawnQueue = GetWorld()->GetSubsystem<USpawnQueueSubsystem>())
+	{
+		SpawnQueue->CancelSpawns(this);
+	}
+	if (URoomStreamingSubsystem* RoomStreaming = GetWorld()->GetSubsystem<URoomStreamingSubsystem>())
+	{
+		RoomStreaming->UnregisterRoom(this);
+	}
+	if (UAssetPreloadSubsystem* Preloader = GetWorld()->GetSubsystem<UAssetPreloadSubsystem>())
+	{
+		Preloader->ReleaseRoom(this);
+	}
+	Super::EndPlay(EndPlayReason);
 }
 
-void AEnemySpawner::ResetEnemy1RepeatTimer()
+void AEnemySpawner::SpawnEntry(const FEnemySpawnEntry& Entry)
 {
-	bSpawnOnCooldown = false;
-	GetWorldTimerManager().ClearTimer(RepeatSpawnEnemy1Handle);
-	UWorld* World = GetWorld();
-	FActorSpawnParameters SpawnParams;
-	SpawnParams.Owner = this;
-	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
-	UClass* GeneratedBPEnemy = Cast<UClass>(Enemy1);
-	World->SpawnActor<AActor>(GeneratedBPEnemy, this->GetActorLocation(), this->GetActorRotation(), SpawnParams);
-	NumberOfRepeatsEnemy1--;
-	if (NumberOfRepeatsEnemy1 <= 0) {
-		bRepeatSpawnEnemy1 = false;
+	//The preloader normally has the class in long before this, a load here hitches and gets logged
+	UClass* EnemyClass = Entry.EnemyClass.LoadSynchronous();
+	if (!EnemyClass)
+	{
+		return;
+	}
+
+	//Spawns from every room share one per frame budget, the queue hands them on to the crowd
+	if (USpawnQueueSubsystem* SpawnQueue = GetWorld()->GetSubsystem<USpawnQueueSubsystem>())
+	{
+		SpawnQueue->SubmitSpawn(EnemyClass, ClaimSpawnLocation(), GetActorRotation(), this, Entry.Health, Entry.Weapon);
+	}
+	//The crowd decides whether the enemy starts as an actor or as a lightweight row
+	else if (UEnemyCrowdSubsystem* Crowd = GetWorld()->GetSubsystem<UEnemyCrowdSubsystem>())
+	{
+		Crowd->SpawnEnemy(EnemyClass, ClaimSpawnLocation(), this->GetActorRotation(), this, Entry.Health, Entry.Weapon);
 	}
 }
 
-// Called every frame
-void AEnemySpawner::Tick(float DeltaTime)
+void AEnemySpawner::BuildSpawnSlots()
 {
-	Super::Tick(DeltaTime);
-	if (bSpawnEnemies && !bCountTimerOnCooldown) {
-		bCountTimerOnCooldown = true;
-		GetWorld()->GetTimerManager().SetTimer(CounterTimeHandle, this, &AEnemySpawner::ResetCounterTimer, 1, false);
-	}
-	else if (bSpawnEnemies && !bSpawnOnCooldown && bDoOnce) {
-		bDoOnce = false;
-		bSpawnOnCooldown = true;
-		GetWorld()->GetTimerManager().SetTimer(RepeatSpawnEnemy1Handle, this, &AEnemySpawner::ResetTimeBeforeSpawnEnemy1Timer, TimeBeforeInitialSpawnEnemy1, false);
+	SpawnSlots.Build(GetWorld(), SpawnPoint->GetComponentLocation(), GetActorRotation(), FMath::Max(SpawnSlotGridSize, 1), SpawnSlotSpacing);
+}
+
+FVector AEnemySpawner::ClaimSpawnLocation(bool bUseSlots)
+{
+	const FVector Center = SpawnPoint->GetComponentLocation();
+	if (!bUseSlots)
+	{
+		return Center;
 	}
-	else if (bSpawnEnemies && bRepeatSpawnEnemy1 && bStartRepeatSpawn && NumberOfRepeatsEnemy1 > 0 && !bSpawnOnCooldown) {
-		bSpawnOnCooldown = true;
-		GetWorld()->GetTimerManager().SetTimer(RepeatSpawnEnemy1Handle, this, &AEnemySpawner::ResetEnemy1RepeatTimer, IntervalBetweenRepeatSpawnsEnemy1, false);
+
+	//A streamed room's nav mesh may not have been there at BeginPlay
+	if (SpawnSlots.GetNumSlots() == 0)
+	{
+		BuildSpawnSlots();
 	}
-	//else if (bStartRepeatSpawn == true && bRepeatSpawnEnemy1 == false) {
-	//	Destroy();
-	//}
+	return SpawnSlots.ClaimSlot(GetWorld(), Center);
+}
+
+float AEnemySpawner::GetSecondsAfterStart() const
+{
+	return bSpawnEnemies ? GetWorld()->GetTimeSeconds() - StartTime : 0.f;
 }
 
 void AEnemySpawner::OnBeginOverlap(AActor* OverlappedActor, AActor* OtherActor)
 {
-	if (OtherActor->ActorHasTag("Player") && !bSpawnEnemies) {
-		bSpawnEnemies = true;
+	if (OtherActor->ActorHasTag("Player")) {
+		if (!bSpawnEnemies) {
+			bSpawnEnemies = true;
+			StartTime = GetWorld()->GetTimeSeconds();
+			if (UWaveDirectorSubsystem* WaveDirector = GetWorld()->GetSubsystem<UWaveDirectorSubsystem>()) {
+				WaveDirector->StartSchedule(this);
+			}
+		}
+		//Enemies in the room the player is in get more detail
+		if (UAISignificanceSubsystem* Significance = GetWorld()->GetSubsystem<UAISignificanceSubsystem>()) {
+			Significance->SetPlayerRoom(this);
+		}
 	}
 }
-
@@ -4,6 +4,8 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "EnemySpawnSchedule.h"
+#include "SpawnSlotGrid.h"
 #include "EnemySpawner.generated.h"
 
 UCLASS()
@@ -19,6 +21,8 @@ protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	//Set up Spawn Points
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SpawnPoints, meta = (AllowPrivateAccess = "true"))
@@ -27,35 +31,40 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SpawnPoints, meta = (AllowPrivateAccess = "true"))
 	USceneComponent* SpawnPoint;
 
-	//Set up which enemies to spawn
+	//Enemies are spread over a grid of nav mesh points around SpawnPoint so they don't spawn inside each other
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SpawnPoints, meta = (AllowPrivateAccess = "true"))
+	int32 SpawnSlotGridSize = 5;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SpawnPoints, meta = (AllowPrivateAccess = "true"))
+	float SpawnSlotSpacing = 120.f;
+	//Seconds before a used slot can be given out again, if no one is still standing on it
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SpawnPoints, meta = (AllowPrivateAccess = "true"))
+	float SpawnSlotHoldSeconds = 2.f;
+
+	FSpawnSlotGrid SpawnSlots;
+
+	//Sublevel holding this room's walls, traps and lights, streamed in and out around the player. Empty keeps it all in the persistent level
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Streaming, meta = (AllowPrivateAccess = "true"))
+	TSoftObjectPtr<UWorld> RoomLevel;
+
+	//Enemies this room spawns once the player walks in, run by the wave director
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Enemies, meta = (AllowPrivateAccess = "true"))
-	UClass* Enemy1;
+	TArray<FEnemySpawnEntry> SpawnSchedule;
 
-	//Set up counter timer to count the seconds after this room has been activated
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Counter, meta = (AllowPrivateAccess = "true"))
-	int SecondsAfterStart = 0;
-	FTimerHandle CounterTimeHandle;
-	bool bCountTimerOnCooldown = false;
-	void ResetCounterTimer();
+	//Set up which enemies to spawn **LEGACY, added to SpawnSchedule at BeginPlay
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Enemies, meta = (AllowPrivateAccess = "true"))
+	TSoftClassPtr<AActor> Enemy1;
 
 	//Set up the times before each enemy is spawned when the player enters the room
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = InitialTimeBeforeSpawn, meta = (AllowPrivateAccess = "true"))
 	int TimeBeforeInitialSpawnEnemy1;
-	FTimerHandle TimeBeforeSpawnEnemy1Handle;
-	bool bSpawnOnCooldown;
-	void ResetTimeBeforeSpawnEnemy1Timer();
 
 	//Repeat enemy spawns?
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = RepeatEnemySpawns, meta = (AllowPrivateAccess = "true"))
 	bool bRepeatSpawnEnemy1;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = RepeatEnemySpawns, meta = (AllowPrivateAccess = "true"))
-	bool bStartRepeatSpawn = false;
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = RepeatEnemySpawns, meta = (AllowPrivateAccess = "true"))
 	int IntervalBetweenRepeatSpawnsEnemy1;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = RepeatEnemySpawns, meta = (AllowPrivateAccess = "true"))
 	int NumberOfRepeatsEnemy1;
-	FTimerHandle RepeatSpawnEnemy1Handle;
-	void ResetEnemy1RepeatTimer();
 
 
 	//Set Up Weapons and health
@@ -64,16 +73,32 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = EnemyStatistics, meta = (AllowPrivateAccess = "true"))
 	int Enemy1weapon;
 
-	bool bDoOnce = true;
-
 	bool bSpawnEnemies = false;
 
-public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
+	//World time the player first entered the room
+	float StartTime = 0.f;
 
+public:	
 	//The delegate function for handling an overlap event
 	UFUNCTION()
 		void OnBeginOverlap(AActor* OverlappedActor, AActor* OtherActor);
 
+	const TArray<FEnemySpawnEntry>& GetSpawnSchedule() const { return SpawnSchedule; }
+
+	//Where the next enemy should go, a free slot around SpawnPoint or SpawnPoint itself without bUseSlots
+	FVector ClaimSpawnLocation(bool bUseSlots = true);
+
+	//Project the spawn slot grid onto the nav mesh. Called again once the room's sublevel, and its nav mesh, is in
+	void BuildSpawnSlots();
+
+	//Spawn dormant enemies for the schedule into the enemy pool, once the preloader has their classes in
+	void PrewarmEnemies();
+
+	//Called by the wave director when one of the schedule's spawns is due, queues the enemy with the spawn queue
+	void SpawnEntry(const FEnemySpawnEntry& Entry);
+
+	//Seconds since the player entered the room, 0 before that
+	UFUNCTION(BlueprintPure, Category = Counter)
+	float GetSecondsAfterStart() const;
+
 };
@@ -0,0 +1,488 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FlowFieldSubsystem.h"
+#include "GameJam2.h"
+#include "AICharacter.h"
+#include "MyAIController.h"
+#include "NavigationSystem.h"
+#include "NavMesh/NavMeshBoundsVolume.h"
+#include "EngineUtils.h"
+#include "Kismet/GameplayStatics.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Flow Field Build"), STAT_FlowFieldBuild, STATGROUP_GameJam2);
+DECLARE_CYCLE_STAT(TEXT("Flow Field Steering"), STAT_FlowFieldSteering, STATGROUP_GameJam2);
+DECLARE_CYCLE_STAT(TEXT("Flow Field Walkability"), STAT_FlowFieldWalkability, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Flow Field Projections"), STAT_FlowFieldProjections, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Flow Field Cells Expanded"), STAT_FlowFieldCellsExpanded, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Flow Field Steered"), STAT_FlowFieldSteered, STATGROUP_GameJam2);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Flow Field Build Time (s)"), STAT_FlowFieldBuildTime, STATGROUP_GameJam2);
+
+//Neighbour offsets, the first four are straight and the last four diagonal
+static const int32 NeighbourX[8] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+static const int32 NeighbourY[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+
+bool UFlowFieldSubsystem::IsTickable() const
+{
+	return Followers.Num() > 0 || NumFieldUsers > 0;
+}
+
+ETickableTickType UFlowFieldSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId UFlowFieldSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UFlowFieldSubsystem, STATGROUP_Tickables);
+}
+
+void UFlowFieldSubsystem::RegisterFollower(AAICharacter* Enemy)
+{
+	if (Enemy)
+	{
+		Followers.AddUnique(Enemy);
+	}
+}
+
+void UFlowFieldSubsystem::UnregisterFollower(AAICharacter* Enemy)
+{
+	Followers.RemoveSwap(Enemy);
+}
+
+void UFlowFieldSubsystem::AddFieldUser()
+{
+	NumFieldUsers++;
+}
+
+void UFlowFieldSubsystem::RemoveFieldUser()
+{
+	NumFieldUsers = FMath::Max(NumFieldUsers - 1, 0);
+}
+
+bool UFlowFieldSubsystem::InitGrid()
+{
+	//Cover every nav mesh bounds volume in the level
+	FBox Bounds(ForceInit);
+	for (TActorIterator<ANavMeshBoundsVolume> It(GetWorld()); It; ++It)
+	{
+		Bounds += It->GetComponentsBoundingBox(true);
+	}
+	if (!Bounds.IsValid)
+	{
+		return false;
+	}
+
+	GridOrigin = FVector2D(Bounds.Min);
+	GridWidth = FMath::Clamp(FMath::CeilToInt((Bounds.Max.X - Bounds.Min.X) / CellSize), 1, MaxGridDimension);
+	GridHeight = FMath::Clamp(FMath::CeilToInt((Bounds.Max.Y - Bounds.Min.Y) / CellSize), 1, MaxGridDimension);
+	GridZ = Bounds.GetCenter().Z;
+	GridHalfHeight = Bounds.GetExtent().Z;
+
+	const int32 NumCells = GridWidth * GridHeight;
+	Walkable.SetNumZeroed(NumCells);
+	WalkabilityCursor = 0;
+	RecheckCells.Reset();
+	ChangedCells.Reset();
+	ActiveCosts.Reset();
+	BuildCosts.SetNumUninitialized(NumCells);
+	bGridReady = true;
+	return true;
+}
+
+bool UFlowFieldSubsystem::WorldToCell(const FVector& Location, int32& OutX, int32& OutY) const
+{
+	OutX = FMath::FloorToInt((Location.X - GridOrigin.X) / CellSize);
+	OutY = FMath::FloorToInt((Location.Y - GridOrigin.Y) / CellSize);
+	return OutX >= 0 && OutY >= 0 && OutX < GridWidth && OutY < GridHeight;
+}
+
+FVector UFlowFieldSubsystem::CellCenter(int32 X, int32 Y) const
+{
+	return FVector(GridOrigin.X + (X + 0.5f) * CellSize, GridOrigin.Y + (Y + 0.5f) * CellSize, GridZ);
+}
+
+bool UFlowFieldSubsystem::ProjectCell(int32 Cell) const
+{
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	FNavLocation Projected;
+	const FVector Extent(CellSize * 0.5f, CellSize * 0.5f, GridHalfHeight + ProjectionHeight);
+	return NavSys && NavSys->ProjectPointToNavigation(CellCenter(Cell % GridWidth, Cell / GridWidth), Projected, Extent);
+}
+
+bool UFlowFieldSubsystem::UpdateWalkability()
+{
+	SCOPE_CYCLE_COUNTER(STAT_FlowFieldWalkability);
+
+	//Nav mesh queries are the expensive part, so they get their own budget and never run inside a build
+	const int32 NumCells = Walkable.Num();
+	int32 Projections = 0;
+	while (WalkabilityCursor < NumCells && Projections < MaxProjectionsPerFrame)
+	{
+		Walkable[WalkabilityCursor] = ProjectCell(WalkabilityCursor) ? 1 : 2;
+		WalkabilityCursor++;
+		Projections++;
+	}
+	while (RecheckCells.Num() > 0 && Projections < MaxProjectionsPerFrame)
+	{
+		const int32 Cell = RecheckCells.Pop(false);
+		const uint8 Value = ProjectCell(Cell) ? 1 : 2;
+		if (Walkable[Cell] != Value)
+		{
+			Walkable[Cell] = Value;
+			ChangedCells.Add(Cell);
+		}
+		Projections++;
+	}
+	SET_DWORD_STAT(STAT_FlowFieldProjections, Projections);
+	return WalkabilityCursor >= NumCells && RecheckCells.Num() == 0;
+}
+
+bool UFlowFieldSubsystem::CanStep(int32 X, int32 Y, int32 n) const
+{
+	const int32 NX = X + NeighbourX[n];
+	const int32 NY = Y + NeighbourY[n];
+	if (NX < 0 || NY < 0 || NX >= GridWidth || NY >= GridHeight || !IsWalkable(NY * GridWidth + NX))
+	{
+		return false;
+	}
+	return n < 4 || (IsWalkable(Y * GridWidth + NX) && IsWalkable(NY * GridWidth + X));
+}
+
+void UFlowFieldSubsystem::InvalidateRegion(const FBox& Box)
+{
+	if (!bGridReady)
+	{
+		return;
+	}
+
+	int32 MinX, MinY, MaxX, MaxY;
+	WorldToCell(Box.Min, MinX, MinY);
+	WorldToCell(Box.Max, MaxX, MaxY);
+	for (int32 Y = FMath::Max(MinY, 0); Y <= FMath::Min(MaxY, GridHeight - 1); Y++)
+	{
+		for (int32 X = FMath::Max(MinX, 0); X <= FMath::Min(MaxX, GridWidth - 1); X++)
+		{
+			RecheckCells.Add(Y * GridWidth + X);
+		}
+	}
+}
+
+void UFlowFieldSubsystem::StartBuild(int32 GoalCell, const FVector& GoalLocation)
+{
+	for (float& Cost : BuildCosts)
+	{
+		Cost = MAX_flt;
+	}
+	Open.Reset();
+
+	BuildGoalCell = GoalCell;
+	BuildGoalLocation = GoalLocation;
+	BuildCosts[GoalCell] = 0.f;
+	Open.HeapPush({ GoalCell, 0.f });
+	bBuilding = true;
+	ChangedCells.Reset();
+	BuildStartTime = FPlatformTime::Seconds();
+}
+
+void UFlowFieldSubsystem::StartRepair()
+{
+	//Patch a copy of the finished field, followers keep sampling the old one until the repair is swapped in
+	BuildCosts = ActiveCosts;
+	Open.Reset();
+	BuildGoalCell = ActiveGoalCell;
+	BuildGoalLocation = ActiveGoalLocation;
+
+	//Cells that were blocked lose their cost
+	Raised.Reset();
+	for (int32 Cell : ChangedCells)
+	{
+		if (!IsWalkable(Cell) && Cell != BuildGoalCell && BuildCosts[Cell] != MAX_flt)
+		{
+			BuildCosts[Cell] = MAX_flt;
+			Raised.Add(Cell);
+		}
+	}
+
+	//So does every cell no neighbour can still reach at its cost, ie it was reached through a lost cell.
+	//Costs only grow along a path, so this stops at cells reached some other way
+	const float DiagonalCost = CellSize * 1.41421356f;
+	for (int32 i = 0; i < Raised.Num(); i++)
+	{
+		const int32 X = Raised[i] % GridWidth;
+		const int32 Y = Raised[i] / GridWidth;
+		for (int32 n = 0; n < 8; n++)
+		{
+			const int32 NX = X + NeighbourX[n];
+			const int32 NY = Y + NeighbourY[n];
+			if (NX < 0 || NY < 0 || NX >= GridWidth || NY >= GridHeight)
+			{
+				continue;
+			}
+			const int32 Cell = NY * GridWidth + NX;
+			if (Cell == BuildGoalCell || BuildCosts[Cell] == MAX_flt)
+			{
+				continue;
+			}
+
+			bool bSupported = false;
+			for (int32 m = 0; m < 8 && !bSupported; m++)
+			{
+				//Stepping from the cell in direction m and back the other way costs the same
+				if (!CanStep(NX, NY, m))
+				{
+					continue;
+				}
+				const float From = BuildCosts[(NY + NeighbourY[m]) * GridWidth + NX + NeighbourX[m]];
+				bSupported = From != MAX_flt && FMath::IsNearlyEqual(From + (m < 4 ? CellSize : DiagonalCost), BuildCosts[Cell], 0.01f);
+			}
+			if (!bSupported)
+			{
+				BuildCosts[Cell] = MAX_flt;
+				Raised.Add(Cell);
+			}
+		}
+	}
+
+	//Grow back into the lost cells and the newly opened ones from the cells around them that kept their cost
+	for (int32 Pass = 0; Pass < 2; Pass++)
+	{
+		for (int32 Seed : Pass == 0 ? Raised : ChangedCells)
+		{
+			const int32 X = Seed % GridWidth;
+			const int32 Y = Seed / GridWidth;
+			for (int32 n = 0; n < 8; n++)
+			{
+				const int32 NX = X + NeighbourX[n];
+				const int32 NY = Y + NeighbourY[n];
+				if (NX >= 0 && NY >= 0 && NX < GridWidth && NY < GridHeight && BuildCosts[NY * GridWidth + NX] != MAX_flt)
+				{
+					Open.HeapPush({ NY * GridWidth + NX, BuildCosts[NY * GridWidth + NX] });
+				}
+			}
+		}
+	}
+
+	bBuilding = true;
+	ChangedCells.Reset();
+	BuildStartTime = FPlatformTime::Seconds();
+}
+
+bool UFlowFieldSubsystem::ContinueBuild()
+{
+	SCOPE_CYCLE_COUNTER(STAT_FlowFieldBuild);
+
+	const float DiagonalCost = CellSize * 1.41421356f;
+	int32 Expanded = 0;
+	while (Open.Num() > 0 && Expanded < MaxCellsPerFrame)
+	{
+		FFlowFieldNode Node;
+		Open.HeapPop(Node, false);
+
+		//Skip stale entries, the cell was reached more cheaply after this was pushed
+		if (Node.Cost > BuildCosts[Node.Cell])
+		{
+			continue;
+		}
+		Expanded++;
+
+		const int32 X = Node.Cell % GridWidth;
+		const int32 Y = Node.Cell / GridWidth;
+		bool bStraightOpen[4] = { false, false, false, false };
+		for (int32 n = 0; n < 8; n++)
+		{
+			const int32 NX = X + NeighbourX[n];
+			const int32 NY = Y + NeighbourY[n];
+			if (NX < 0 || NY < 0 || NX >= GridWidth || NY >= GridHeight)
+			{
+				continue;
+			}
+			const int32 Neighbour = NY * GridWidth + NX;
+			if (n >= 4)
+			{
+				//No cutting corners, both straight cells next to the diagonal must be open
+				const bool bXOpen = bStraightOpen[NeighbourX[n] > 0 ? 0 : 1];
+				const bool bYOpen = bStraightOpen[NeighbourY[n] > 0 ? 2 : 3];
+				if (!bXOpen || !bYOpen)
+				{
+					continue;
+				}
+			}
+			if (!IsWalkable(Neighbour))
+			{
+				continue;
+			}
+			if (n < 4)
+			{
+				bStraightOpen[n] = true;
+			}
+
+			const float Cost = Node.Cost + (n < 4 ? CellSize : DiagonalCost);
+			if (Cost < BuildCosts[Neighbour] && Cost <= MaxFieldCost)
+			{
+				BuildCosts[Neighbour] = Cost;
+				Open.HeapPush({ Neighbour, Cost });
+			}
+		}
+	}
+	INC_DWORD_STAT_BY(STAT_FlowFieldCellsExpanded, Expanded);
+
+	if (Open.Num() > 0)
+	{
+		return false;
+	}
+
+	//Swap the finished field in, the old one becomes next build's scratch
+	Swap(ActiveCosts, BuildCosts);
+	BuildCosts.SetNumUninitialized(ActiveCosts.Num());
+	ActiveGoalCell = BuildGoalCell;
+	ActiveGoalLocation = BuildGoalLocation;
+	bBuilding = false;
+	SET_FLOAT_STAT(STAT_FlowFieldBuildTime, FPlatformTime::Seconds() - BuildStartTime);
+	return true;
+}
+
+bool UFlowFieldSubsystem::SampleDirection(const FVector& Location, FVector& OutDirection) const
+{
+	int32 X, Y;
+	if (ActiveCosts.Num() == 0 || !WorldToCell(Location, X, Y))
+	{
+		return false;
+	}
+
+	const int32 Cell = Y * GridWidth + X;
+	if (ActiveCosts[Cell] == MAX_flt)
+	{
+		return false;
+	}
+	if (Cell == ActiveGoalCell)
+	{
+		OutDirection = (ActiveGoalLocation - Location).GetSafeNormal2D();
+		return true;
+	}
+
+	//Head for the cheapest neighbour, diagonals only when both straight cells beside them are in the field
+	float BestCost = ActiveCosts[Cell];
+	int32 BestX = INDEX_NONE;
+	int32 BestY = INDEX_NONE;
+	for (int32 n = 0; n < 8; n++)
+	{
+		const int32 NX = X + NeighbourX[n];
+		const int32 NY = Y + NeighbourY[n];
+		if (NX < 0 || NY < 0 || NX >= GridWidth || NY >= GridHeight)
+		{
+			continue;
+		}
+		if (n >= 4 && (ActiveCosts[Y * GridWidth + NX] == MAX_flt || ActiveCosts[NY * GridWidth + X] == MAX_flt))
+		{
+			continue;
+		}
+		const float Cost = ActiveCosts[NY * GridWidth + NX];
+		if (Cost < BestCost)
+		{
+			BestCost = Cost;
+			BestX = NX;
+			BestY = NY;
+		}
+	}
+	if (BestX == INDEX_NONE)
+	{
+		return false;
+	}
+
+	OutDirection = (CellCenter(BestX, BestY) - Location).GetSafeNormal2D();
+	return true;
+}
+
+void UFlowFieldSubsystem::SteerFollowers()
+{
+	SCOPE_CYCLE_COUNTER(STAT_FlowFieldSteering);
+
+	const float AcceptanceRadiusSq = AcceptanceRadius * AcceptanceRadius;
+	int32 Steered = 0;
+	for (int32 i = Followers.Num() - 1; i >= 0; i--)
+	{
+		AAICharacter* Enemy = Followers[i].Get();
+		if (!Enemy)
+		{
+			Followers.RemoveAtSwap(i, 1, false);
+			continue;
+		}
+
+		//Only enemies chasing something follow the field, the rest are left to the behaviour tree
+		AMyAIController* Controller = Cast<AMyAIController>(Enemy->GetController());
+		AActor* Target = Controller ? Controller->GetSeenTarget() : nullptr;
+		if (!Target)
+		{
+			continue;
+		}
+
+		//Squad members close enough to their fire slot head straight for it instead of the target
+		const FVector Location = Enemy->GetActorLocation();
+		if (Enemy->bHasSquadSlot && FVector::DistSquared2D(Location, Target->GetActorLocation()) < SlotApproachDistance * SlotApproachDistance)
+		{
+			if (FVector::DistSquared2D(Location, Enemy->SquadSlot) >= AcceptanceRadiusSq)
+			{
+				Enemy->AddMovementInput((Enemy->SquadSlot - Location).GetSafeNormal2D());
+				Steered++;
+			}
+			continue;
+		}
+
+		if (FVector::DistSquared2D(Location, Target->GetActorLocation()) < AcceptanceRadiusSq)
+		{
+			continue;
+		}
+
+		FVector Direction;
+		if (SampleDirection(Location, Direction))
+		{
+			Enemy->AddMovementInput(Direction);
+			Steered++;
+		}
+	}
+	SET_DWORD_STAT(STAT_FlowFieldSteered, Steered);
+}
+
+void UFlowFieldSubsystem::Tick(float DeltaTime)
+{
+	if (!bGridReady && !InitGrid())
+	{
+		return;
+	}
+
+	//Builds wait until every cell's walkability is known, and a repair until the changed cells are found
+	const bool bWalkabilityKnown = UpdateWalkability();
+
+	APawn* Player = UGameplayStatics::GetPlayerPawn(this, 0);
+	if (Player)
+	{
+		//Finish the running build before starting the next one so a moving player still gets a field
+		const FVector PlayerLocation = Player->GetActorLocation();
+		int32 X, Y;
+		if (!bBuilding && bWalkabilityKnown && WorldToCell(PlayerLocation, X, Y))
+		{
+			const int32 PlayerCell = Y * GridWidth + X;
+			if (PlayerCell != ActiveGoalCell)
+			{
+				StartBuild(PlayerCell, PlayerLocation);
+			}
+			else
+			{
+				ActiveGoalLocation = PlayerLocation;
+				if (ChangedCells.Num() > 0)
+				{
+					StartRepair();
+				}
+			}
+		}
+	}
+
+	if (bBuilding)
+	{
+		ContinueBuild();
+	}
+
+	SteerFollowers();
+}
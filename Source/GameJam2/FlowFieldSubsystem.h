@@ -0,0 +1,149 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FlowFieldSubsystem.generated.h"
+
+class AAICharacter;
+
+//A cell waiting to be expanded by the field build
+struct FFlowFieldNode
+{
+	int32 Cell;
+	float Cost;
+
+	bool operator<(const FFlowFieldNode& Other) const { return Cost < Other.Cost; }
+};
+
+/**
+ * One shared path to the player for every enemy. A grid is laid over the nav mesh bounds, its cells are
+ * projected onto the nav mesh a budgeted number per frame, then a Dijkstra field of path cost to the
+ * player's cell is built a few thousand cells per frame. Invalidated regions are projected again and
+ * only the part of the field that went through changed cells is rebuilt.
+ * Enemies sample their steering direction from the finished field in constant time, so pathfinding
+ * is paid once per player move instead of once per enemy.
+ */
+UCLASS(config = Game)
+class GAMEJAM2_API UFlowFieldSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End FTickableGameObject interface
+
+	//Enemies registered here are steered along the field while they have a target
+	void RegisterFollower(AAICharacter* Enemy);
+	void UnregisterFollower(AAICharacter* Enemy);
+
+	//Anything else sampling the field, like the crowd's rows, keeps it building while it holds a use
+	void AddFieldUser();
+	void RemoveFieldUser();
+
+	//Direction along the field towards the player, false if the location isn't covered by the field
+	bool SampleDirection(const FVector& Location, FVector& OutDirection) const;
+
+	//Work out walkability inside the box again, eg when a door opens, and patch the field where it changed
+	void InvalidateRegion(const FBox& Box);
+
+	//Size of one grid cell
+	UPROPERTY(Config)
+	float CellSize = 100.f;
+
+	//The grid is clamped to this many cells on a side
+	UPROPERTY(Config)
+	int32 MaxGridDimension = 512;
+
+	//Path cost (in world units) past which cells are left out of the field
+	UPROPERTY(Config)
+	float MaxFieldCost = 8000.f;
+
+	//Cells expanded per frame while a field is being built
+	UPROPERTY(Config)
+	int32 MaxCellsPerFrame = 4096;
+
+	//Nav mesh projections per frame while working out which cells are walkable
+	UPROPERTY(Config)
+	int32 MaxProjectionsPerFrame = 1024;
+
+	//Height above and below a cell centre searched for nav mesh
+	UPROPERTY(Config)
+	float ProjectionHeight = 200.f;
+
+	//Followers stop steering when they are this close to the player
+	UPROPERTY(Config)
+	float AcceptanceRadius = 150.f;
+
+	//Within this distance of the target, squad members leave the field and walk to their fire slot
+	UPROPERTY(Config)
+	float SlotApproachDistance = 1500.f;
+
+private:
+	bool InitGrid();
+
+	bool WorldToCell(const FVector& Location, int32& OutX, int32& OutY) const;
+
+	FVector CellCenter(int32 X, int32 Y) const;
+
+	bool IsWalkable(int32 Cell) const { return Walkable[Cell] == 1; }
+
+	bool ProjectCell(int32 Cell) const;
+
+	//Project cells up to MaxProjectionsPerFrame, true once every cell's walkability is known
+	bool UpdateWalkability();
+
+	//Whether the field can step from the cell in direction n, diagonals need both straight cells beside them open
+	bool CanStep(int32 X, int32 Y, int32 n) const;
+
+	void StartBuild(int32 GoalCell, const FVector& GoalLocation);
+
+	//Rebuild only the cells whose path went through ChangedCells, starting from the finished field
+	void StartRepair();
+
+	//Expand up to MaxCellsPerFrame cells, returns true when the build is finished
+	bool ContinueBuild();
+
+	void SteerFollowers();
+
+	TArray<TWeakObjectPtr<AAICharacter>> Followers;
+	int32 NumFieldUsers = 0;
+
+	bool bGridReady = false;
+	FVector2D GridOrigin = FVector2D::ZeroVector;
+	int32 GridWidth = 0;
+	int32 GridHeight = 0;
+	float GridZ = 0.f;
+	float GridHalfHeight = 0.f;
+
+	//0 unknown, 1 walkable, 2 blocked. Filled in before the first build
+	TArray<uint8> Walkable;
+	int32 WalkabilityCursor = 0;
+
+	//Cells to project again after an invalidate, and the ones whose walkability turned out different
+	TArray<int32> RecheckCells;
+	TArray<int32> ChangedCells;
+
+	//Repair scratch: cells that lost their cost
+	TArray<int32> Raised;
+
+	//Finished field the followers sample from
+	TArray<float> ActiveCosts;
+	int32 ActiveGoalCell = INDEX_NONE;
+	FVector ActiveGoalLocation = FVector::ZeroVector;
+
+	//Field being built over several frames
+	TArray<float> BuildCosts;
+	TArray<FFlowFieldNode> Open;
+	int32 BuildGoalCell = INDEX_NONE;
+	FVector BuildGoalLocation = FVector::ZeroVector;
+	bool bBuilding = false;
+	double BuildStartTime = 0.0;
+};
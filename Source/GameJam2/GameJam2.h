@@ -5,3 +5,6 @@
 #include "CoreMinimal.h"
 
 DECLARE_LOG_CATEGORY_EXTERN(LogGameJam2, Log, All);
+
+//Stat group for the gameplay systems, view in game with "stat GameJam2"
+DECLARE_STATS_GROUP(TEXT("GameJam2"), STATGROUP_GameJam2, STATCAT_Advanced);
@@ -14,6 +14,15 @@
 #include "Kismet/KismetMathLibrary.h"
 #include "Kismet/GameplayStatics.h"
 #include "Engine/World.h"
+#include "GameJam2.h"
+#include "Engine/DataTable.h"
+#include "ProjectilePoolSubsystem.h"
+#include "ProjectileSimulationSubsystem.h"
+#include "HitscanSubsystem.h"
+#include "GunshotAudioSubsystem.h"
+#include "PawnPerceptionSubsystem.h"
+
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Player Fire Latency (ms)"), STAT_PlayerFireLatency, STATGROUP_GameJam2);
 
 AGameJam2Character::AGameJam2Character()
 {
@@ -55,11 +64,100 @@ AGameJam2Character::AGameJam2Character()
 	//Flashlight->SetRelativeLocation(FVector(0.f, 0.f, 0.f));
 	//Flashlight->SetRelativeRotation(FRotator(0.f, 0.f, 0.f));
 
+	// Default weapons, can be replaced in the blueprint or with a WeaponTable
+	FWeaponDefinition Pistol;
+	Pistol.WeaponName = TEXT("Pistol");
+	Pistol.FiringMode = 0;
+	Pistol.MaxAmmo = 50;
+	Pistol.ClipSize = 10;
+	Pistol.ShootSpeed = 0.3f;
+	Weapons.Add(Pistol);
+
+	FWeaponDefinition AK;
+	AK.WeaponName = TEXT("AK");
+	AK.FiringMode = 1;
+	AK.MaxAmmo = 120;
+	AK.ClipSize = 30;
+	AK.ShootSpeed = 0.3f;
+	Weapons.Add(AK);
+
+	FWeaponDefinition SMG;
+	SMG.WeaponName = TEXT("SMG");
+	SMG.FiringMode = 1;
+	SMG.MaxAmmo = 80;
+	SMG.ClipSize = 20;
+	SMG.ShootSpeed = 0.05f;
+	Weapons.Add(SMG);
+
+	FWeaponDefinition Shotgun;
+	Shotgun.WeaponName = TEXT("Shotgun");
+	Shotgun.FiringMode = 0;
+	Shotgun.MaxAmmo = 24;
+	Shotgun.ClipSize = 6;
+	Shotgun.ShootSpeed = 0.3f;
+	Shotgun.PelletCount = 5;
+	Shotgun.SpreadPattern = EWeaponSpreadPattern::Fan;
+	Shotgun.SpreadAngle = 30.f;
+	Weapons.Add(Shotgun);
+
 	// Activate ticking in order to update the cursor every frame.
 	PrimaryActorTick.bCanEverTick = true;
 	PrimaryActorTick.bStartWithTickEnabled = true;
 }
 
+void AGameJam2Character::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (WeaponTable)
+	{
+		TArray<FWeaponDefinition*> Rows;
+		WeaponTable->GetAllRows<FWeaponDefinition>(TEXT("AGameJam2Character::BeginPlay"), Rows);
+		Weapons.Reset(Rows.Num());
+		for (const FWeaponDefinition* Row : Rows)
+		{
+			Weapons.Add(*Row);
+		}
+	}
+
+	//Start every weapon full
+	WeaponStates.SetNum(Weapons.Num());
+	for (int i = 0; i < Weapons.Num(); i++)
+	{
+		WeaponStates[i].Ammo = Weapons[i].MaxAmmo;
+		WeaponStates[i].AmmoInClip = FMath::Min(Weapons[i].ClipSize, Weapons[i].MaxAmmo);
+	}
+	UpdateHUDAmmo();
+
+	//Spawn dormant bullets up front so the first shots don't have to
+	if (UProjectilePoolSubsystem* Pool = GetWorld()->GetSubsystem<UProjectilePoolSubsystem>())
+	{
+		Pool->PrewarmPool(BulletProjectileClass);
+		for (const FWeaponDefinition& Weapon : Weapons)
+		{
+			Pool->PrewarmPool(Weapon.ProjectileClass);
+		}
+	}
+
+	EquipWeapon(CurrentWeapon);
+	LastMuzzleTransform = MuzzleLocation->GetComponentTransform();
+
+	//Let the enemies see us
+	if (UPawnPerceptionSubsystem* Perception = GetWorld()->GetSubsystem<UPawnPerceptionSubsystem>())
+	{
+		Perception->RegisterPawn(this, true);
+	}
+}
+
+void AGameJam2Character::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UPawnPerceptionSubsystem* Perception = GetWorld()->GetSubsystem<UPawnPerceptionSubsystem>())
+	{
+		Perception->UnregisterPawn(this);
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
 void AGameJam2Character::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
 {
 	PlayerInputComponent->BindAxis("MoveForward", this, &AGameJam2Character::MoveForward);
@@ -69,6 +167,7 @@ void AGameJam2Character::SetupPlayerInputComponent(UInputComponent* PlayerInputC
 	PlayerInputComponent->BindAction("SelectPistol", IE_Pressed, this, &AGameJam2Character::SelectPistol);
 	PlayerInputComponent->BindAction("SelectAK", IE_Pressed, this, &AGameJam2Character::SelectAK);
 	PlayerInputComponent->BindAction("SelectSMG", IE_Pressed, this, &AGameJam2Character::SelectSMG);
+	PlayerInputComponent->BindAction("SelectShotgun", IE_Pressed, this, &AGameJam2Character::SelectShotgun);
 	PlayerInputComponent->BindAction("Reload", IE_Pressed, this, &AGameJam2Character::Reload);
 }
 
@@ -87,120 +186,135 @@ void AGameJam2Character::Tick(float DeltaSeconds)
 		this->SetActorRotation(RotationToLookAt);
 	}
 
-	if (bShoot && bDead == false) {
-		if (CurrentWeapon == 0)
+	UpdateFiring(DeltaSeconds);
+}
+
+void AGameJam2Character::UpdateFiring(float DeltaSeconds)
+{
+	//Stops a long hitch from emptying a clip in one frame
+	static const int MaxShotsPerFrame = 16;
+
+	const FTransform MuzzleTransform = MuzzleLocation->GetComponentTransform();
+	const float Now = GetWorld()->GetTimeSeconds();
+	UGunshotAudioSubsystem* GunshotAudio = GetWorld()->GetSubsystem<UGunshotAudioSubsystem>();
+
+	//Single fire weapons need the button released between shots
+	const bool bTriggerReady = CurrentFiringMode == 1 || bShootOnce;
+	const bool bWantsFire = bShoot && bDead == false && bTriggerReady && bReloading == false && WeaponStates.IsValidIndex(CurrentWeapon) && CurrentProjectileClass;
+	if (bWantsFire)
+	{
+		FWeaponState& State = WeaponStates[CurrentWeapon];
+		const float ShotInterval = FMath::Max(CurrentShootSpeed, 0.001f);
+
+		//Only carry fire time over from a frame we were already firing in, otherwise the first shot is now
+		if (!bFiringLastFrame)
 		{
-			if (bReloading == false && CurrentPistolAmmo > 0 && CurrentAmmoInPistolClip > 0)
-			{
-				if (CurrentFiringMode == 0 && bShootOnce)
-				{
-					UWorld* World = GetWorld();
-					FActorSpawnParameters SpawnParams;
-					SpawnParams.Owner = this;
-					SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
-					if (CurrentProjectileClass->IsValidLowLevelFast() && MuzzleLocation->IsValidLowLevelFast())
-					{
-						FHitResult Hit;
-						UClass* GenerateBPBullet = Cast<UClass>(CurrentProjectileClass);
-						World->SpawnActor<AActor>(GenerateBPBullet, MuzzleLocation->GetComponentLocation(), MuzzleLocation->GetComponentRotation(), SpawnParams);
-						if (CurrentShootSound->IsValidLowLevelFast())
-						{
-							UGameplayStatics::PlaySoundAtLocation(this, CurrentShootSound, GetActorLocation());
-						}
-						bShootOnce = false;
-						CurrentPistolAmmo--;
-						CurrentAmmoInPistolClip--;
-						if (CurrentAmmoInPistolClip <= 0)
-						{
-							bReloading = true;
-							GetWorld()->GetTimerManager().SetTimer(ReloadTimerHandle, this, &AGameJam2Character::ResetReloadTimer, ReloadSpeed, false);
-							if (CurrentReloadSound->IsValidLowLevelFast())
-							{
-								UGameplayStatics::PlaySoundAtLocation(this, CurrentReloadSound, GetActorLocation());
-							}
-						}
-						else
-						{
-							bShootOnCooldown = true;
-							GetWorld()->GetTimerManager().SetTimer(ShootSpeedTimerHandle, this, &AGameJam2Character::ResetShootSpeedTimer, ShootSpeed, false);
-						}
-					}
-				}
-			}
+			State.NextShotTime = FMath::Max(State.NextShotTime, Now);
 		}
-		if (CurrentWeapon == 1)
+
+		int ShotsThisFrame = 0;
+		while (State.NextShotTime <= Now && State.Ammo > 0 && State.AmmoInClip > 0 && ShotsThisFrame < MaxShotsPerFrame)
 		{
-			if (bReloading == false && bShootOnCooldown == false && CurrentAKAmmo > 0 && CurrentAmmoInAKClip > 0)
+			//Place the shot where the muzzle was when it was due
+			const float ShotAge = FMath::Min(Now - State.NextShotTime, DeltaSeconds);
+			const float Alpha = DeltaSeconds > 0.f ? 1.f - ShotAge / DeltaSeconds : 1.f;
+			FTransform ShotMuzzle;
+			ShotMuzzle.Blend(LastMuzzleTransform, MuzzleTransform, Alpha);
+
+			FireProjectile(ShotMuzzle, ShotAge);
+			if (CurrentShootSound && GunshotAudio)
 			{
-				UWorld* World = GetWorld();
-				FActorSpawnParameters SpawnParams;
-				SpawnParams.Owner = this;
-				SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
-				if (CurrentProjectileClass->IsValidLowLevelFast() && MuzzleLocation->IsValidLowLevelFast())
-				{
-					FHitResult Hit;
-					UClass* GeneratedBPBullet = Cast<UClass>(CurrentProjectileClass);
-					World->SpawnActor<AActor>(GeneratedBPBullet, MuzzleLocation->GetComponentLocation(), MuzzleLocation->GetComponentRotation(), SpawnParams);
-					if (CurrentShootSound->IsValidLowLevelFast())
-					{
-						UGameplayStatics::PlaySoundAtLocation(this, CurrentShootSound, GetActorLocation());
-					}
-					CurrentAKAmmo--;
-					CurrentAmmoInAKClip--;
-					if (CurrentAmmoInAKClip <= 0)
-					{
-						bReloading = true;
-						GetWorld()->GetTimerManager().SetTimer(ReloadTimerHandle, this, &AGameJam2Character::ResetReloadTimer, ReloadSpeed, false);
-						if (CurrentReloadSound->IsValidLowLevelFast()) {
-							UGameplayStatics::PlaySoundAtLocation(this, CurrentReloadSound, GetActorLocation());
-						}
-					}
-					else
-					{
-						bShootOnCooldown = true;
-						GetWorld()->GetTimerManager().SetTimer(ShootSpeedTimerHandle, this, &AGameJam2Character::ResetShootSpeedTimer, ShootSpeed, false);
-					}
-				}
+				GunshotAudio->PlayGunshot(CurrentShootSound, ShotMuzzle.GetLocation());
 			}
+			ShotsThisFrame++;
+			bShootOnce = false;
+			State.Ammo--;
+			State.AmmoInClip--;
+			State.NextShotTime += ShotInterval;
 
-		}
-		if (CurrentWeapon == 2)
-		{
-			if (bReloading == false && bShootOnCooldown == false && CurrentSMGAmmo > 0 && CurrentAmmoInSMGClip > 0)
+			if (State.AmmoInClip <= 0)
+			{
+				StartReload();
+				break;
+			}
+			if (CurrentFiringMode == 0)
 			{
-				UWorld* World = GetWorld();
-				FActorSpawnParameters SpawnParams;
-				SpawnParams.Owner = this;
-				SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
-				if (CurrentProjectileClass->IsValidLowLevelFast() && MuzzleLocation->IsValidLowLevelFast())
-				{
-					FHitResult Hit;
-					UClass* GeneratedBPBullet = Cast<UClass>(CurrentProjectileClass);
-					World->SpawnActor<AActor>(GeneratedBPBullet, MuzzleLocation->GetComponentLocation(), MuzzleLocation->GetComponentRotation(), SpawnParams);
-					if (CurrentShootSound->IsValidLowLevelFast())
-					{
-						UGameplayStatics::PlaySoundAtLocation(this, CurrentShootSound, GetActorLocation());
-					}
-					CurrentSMGAmmo--;
-					CurrentAmmoInSMGClip--;
-					if (CurrentAmmoInSMGClip <= 0)
-					{
-						bReloading = true;
-						GetWorld()->GetTimerManager().SetTimer(ReloadTimerHandle, this, &AGameJam2Character::ResetReloadTimer, ReloadSpeed, false);
-						if (CurrentReloadSound->IsValidLowLevelFast()) {
-							UGameplayStatics::PlaySoundAtLocation(this, CurrentReloadSound, GetActorLocation());
-						}
-					}
-					else
-					{
-						bShootOnCooldown = true;
-						GetWorld()->GetTimerManager().SetTimer(ShootSpeedTimerHandle, this, &AGameJam2Character::ResetShootSpeedTimer, SMGShootSpeed, false);
-					}
-				}
+				break;
 			}
+		}
+
+		if (ShotsThisFrame > 0)
+		{
+			UpdateHUDAmmo();
+		}
 
+		if (State.NextShotTime < Now - ShotInterval)
+		{
+			//Hit the per frame cap, drop the backlog rather than firing it over the next frames
+			State.NextShotTime = Now;
 		}
 	}
+	bFiringLastFrame = bWantsFire && bReloading == false;
+	LastMuzzleTransform = MuzzleTransform;
+}
+
+void AGameJam2Character::FireProjectile(const FTransform& Muzzle, float ShotAge)
+{
+	if (ShootPressedTime > 0.0)
+	{
+		LastFireLatencyMs = float((FPlatformTime::Seconds() - ShootPressedTime) * 1000.0);
+		SET_FLOAT_STAT(STAT_PlayerFireLatency, LastFireLatencyMs);
+		ShootPressedTime = 0.0;
+	}
+
+	BuildVolley(Weapons[CurrentWeapon], Muzzle);
+
+	if (bCurrentWeaponHitscan)
+	{
+		if (UHitscanSubsystem* Hitscan = GetWorld()->GetSubsystem<UHitscanSubsystem>())
+		{
+			Hitscan->QueueShots(CurrentProjectileClass, PelletTransforms, this);
+		}
+	}
+	else if (bCurrentWeaponSimulated)
+	{
+		if (UProjectileSimulationSubsystem* Simulation = GetWorld()->GetSubsystem<UProjectileSimulationSubsystem>())
+		{
+			Simulation->SpawnBullets(CurrentProjectileClass, PelletTransforms, this, ShotAge);
+		}
+	}
+	else if (UProjectilePoolSubsystem* Pool = GetWorld()->GetSubsystem<UProjectilePoolSubsystem>())
+	{
+		Pool->AcquireProjectiles(CurrentProjectileClass, PelletTransforms, this, ShotAge);
+	}
+}
+
+void AGameJam2Character::BuildVolley(const FWeaponDefinition& Weapon, const FTransform& Muzzle)
+{
+	const int NumPellets = FMath::Max(Weapon.PelletCount, 1);
+	const FVector MuzzlePosition = Muzzle.GetLocation();
+	const FQuat MuzzleRotation = Muzzle.GetRotation();
+	FRandomStream Stream(Weapon.SpreadSeed + VolleyCount++);
+
+	PelletTransforms.Reset(NumPellets);
+	for (int i = 0; i < NumPellets; i++)
+	{
+		//Top down game, so spread is yaw only
+		float Yaw = 0.f;
+		switch (Weapon.SpreadPattern)
+		{
+		case EWeaponSpreadPattern::Fan:
+			Yaw = NumPellets > 1 ? FMath::Lerp(-0.5f, 0.5f, float(i) / (NumPellets - 1)) * Weapon.SpreadAngle : 0.f;
+			break;
+		case EWeaponSpreadPattern::AngleTable:
+			Yaw = Weapon.PelletAngles.Num() > 0 ? Weapon.PelletAngles[i % Weapon.PelletAngles.Num()] : 0.f;
+			break;
+		case EWeaponSpreadPattern::SeededCone:
+			Yaw = Stream.FRandRange(-0.5f, 0.5f) * Weapon.SpreadAngle;
+			break;
+		}
+		PelletTransforms.Emplace(MuzzleRotation * FQuat(FVector::UpVector, FMath::DegreesToRadians(Yaw)), MuzzlePosition);
+	}
 }
 
 void AGameJam2Character::setFiringMode(int mode)
@@ -221,60 +335,120 @@ void AGameJam2Character::ReceiveDamage(int ammount)
 	}
 }
 
+float AGameJam2Character::TakeDamage(float DamageAmount, FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser)
+{
+	const float ActualDamage = Super::TakeDamage(DamageAmount, DamageEvent, EventInstigator, DamageCauser);
+	if (ActualDamage > 0.f && bDead == false)
+	{
+		ReceiveDamage(FMath::RoundToInt(ActualDamage));
+	}
+	return ActualDamage;
+}
+
 void AGameJam2Character::Die()
 {
 	bDead = true;
 }
 
-void AGameJam2Character::ResetShootSpeedTimer()
+void AGameJam2Character::ResetReloadTimer()
 {
-	bShootOnCooldown = false;
-	GetWorldTimerManager().ClearTimer(ShootSpeedTimerHandle);
+	if (WeaponStates.IsValidIndex(CurrentWeapon))
+	{
+		FWeaponState& State = WeaponStates[CurrentWeapon];
+		State.AmmoInClip = FMath::Min(State.Ammo, Weapons[CurrentWeapon].ClipSize);
+		UpdateHUDAmmo();
+	}
+	bReloading = false;
+	GetWorldTimerManager().ClearTimer(ReloadTimerHandle);
 }
 
-void AGameJam2Character::ResetReloadTimer()
+void AGameJam2Character::UpdateHUDAmmo()
 {
-	if (CurrentWeapon == 0)
+	//PlayerHUD still binds the old per weapon properties, weapon ids 0-2 are the pistol, AK and SMG
+	int* const Ammo[] = { &CurrentPistolAmmo, &CurrentAKAmmo, &CurrentSMGAmmo };
+	int* const MaxAmmo[] = { &CurrentPistolMaxAmmo, &CurrentAKMaxAmmo, &CurrentSMGMaxAmmo };
+	int* const ClipSize[] = { &CurrentPistolClipSize, &CurrentAKClipSize, &CurrentSMGClipSize };
+	int* const AmmoInClip[] = { &CurrentAmmoInPistolClip, &CurrentAmmoInAKClip, &CurrentAmmoInSMGClip };
+	for (int i = 0; i < 3 && WeaponStates.IsValidIndex(i); i++)
 	{
-		if (CurrentPistolAmmo >= CurrentPistolClipSize) 
-		{
-			CurrentAmmoInPistolClip = CurrentPistolClipSize;
-		}
-		else if (CurrentPistolAmmo < CurrentPistolClipSize && CurrentPistolAmmo > 0) 
-		{
-			CurrentAmmoInPistolClip = CurrentPistolAmmo;
-		}
-		bReloading = false;
-		GetWorldTimerManager().ClearTimer(ReloadTimerHandle);
+		*Ammo[i] = WeaponStates[i].Ammo;
+		*AmmoInClip[i] = WeaponStates[i].AmmoInClip;
+		*MaxAmmo[i] = Weapons[i].MaxAmmo;
+		*ClipSize[i] = Weapons[i].ClipSize;
 	}
-	else if (CurrentWeapon == 1)
+}
+
+void AGameJam2Character::StartReload()
+{
+	bReloading = true;
+	GetWorld()->GetTimerManager().SetTimer(ReloadTimerHandle, this, &AGameJam2Character::ResetReloadTimer, CurrentReloadSpeed, false);
+	UGunshotAudioSubsystem* GunshotAudio = GetWorld()->GetSubsystem<UGunshotAudioSubsystem>();
+	if (CurrentReloadSound && GunshotAudio)
 	{
-		if (CurrentAKAmmo >= CurrentAKClipSize)
-		{
-			CurrentAmmoInAKClip = CurrentAKClipSize;
-		}
-		else if (CurrentAKAmmo < CurrentAKClipSize && CurrentAKAmmo > 0)
-		{
-			CurrentAmmoInAKClip = CurrentAKAmmo;
-		}
-		bReloading = false;
-		GetWorldTimerManager().ClearTimer(ReloadTimerHandle);
+		GunshotAudio->PlayGunshot(CurrentReloadSound, GetActorLocation());
+	}
+}
+
+void AGameJam2Character::EquipWeapon(int WeaponId)
+{
+	if (!Weapons.IsValidIndex(WeaponId))
+	{
+		return;
 	}
-	else if (CurrentWeapon == 2)
+
+	//Resolve everything the fire path needs once here instead of on every shot
+	const FWeaponDefinition& Weapon = Weapons[WeaponId];
+	CurrentWeapon = WeaponId;
+	CurrentFiringMode = Weapon.FiringMode;
+	if (Weapon.ProjectileClass)
 	{
-		if (CurrentSMGAmmo >= CurrentSMGClipSize)
-		{
-			CurrentAmmoInSMGClip = CurrentSMGClipSize;
-		}
-		else if (CurrentSMGAmmo < CurrentSMGClipSize && CurrentSMGAmmo > 0)
+		CurrentProjectileClass = Weapon.ProjectileClass;
+	}
+	CurrentShootSpeed = Weapon.ShootSpeed;
+	CurrentReloadSpeed = Weapon.ReloadSpeed;
+	bCurrentWeaponHitscan = Weapon.bHitscan;
+	bCurrentWeaponSimulated = Weapon.bSimulateProjectiles;
+
+	//The new weapon's fire time is from when it was last used, don't let it catch up on shots while the trigger is held
+	bFiringLastFrame = false;
+
+	if (Weapon.ShootSound)
+	{
+		CurrentShootSound = Weapon.ShootSound;
+	}
+	if (Weapon.ReloadSound)
+	{
+		CurrentReloadSound = Weapon.ReloadSound;
+	}
+
+	if (!bCurrentWeaponHitscan && !bCurrentWeaponSimulated)
+	{
+		if (UProjectilePoolSubsystem* Pool = GetWorld()->GetSubsystem<UProjectilePoolSubsystem>())
 		{
-			CurrentAmmoInSMGClip = CurrentSMGAmmo;
+			Pool->PrewarmPool(CurrentProjectileClass);
 		}
-		bReloading = false;
-		GetWorldTimerManager().ClearTimer(ReloadTimerHandle);
 	}
 }
 
+int AGameJam2Character::GetCurrentAmmo() const
+{
+	return WeaponStates.IsValidIndex(CurrentWeapon) ? WeaponStates[CurrentWeapon].Ammo : 0;
+}
+
+int AGameJam2Character::GetCurrentAmmoInClip() const
+{
+	return WeaponStates.IsValidIndex(CurrentWeapon) ? WeaponStates[CurrentWeapon].AmmoInClip : 0;
+}
+
+int AGameJam2Character::GetCurrentMaxAmmo() const
+{
+	return Weapons.IsValidIndex(CurrentWeapon) ? Weapons[CurrentWeapon].MaxAmmo : 0;
+}
+
+int AGameJam2Character::GetCurrentClipSize() const
+{
+	return Weapons.IsValidIndex(CurrentWeapon) ? Weapons[CurrentWeapon].ClipSize : 0;
+}
 
 void AGameJam2Character::MoveForward(float Value)
 {
@@ -309,6 +483,7 @@ void AGameJam2Character::ShootPressed()
 {
 	this->bShoot = true;
 	this->bShootOnce = true;
+	ShootPressedTime = FPlatformTime::Seconds();
 }
 
 void AGameJam2Character::ShootReleased()
@@ -318,25 +493,25 @@ void AGameJam2Character::ShootReleased()
 
 void AGameJam2Character::SelectPistol()
 {
-	CurrentWeapon = 0;
-	CurrentFiringMode = 0;
+	EquipWeapon(0);
 }
 
 void AGameJam2Character::SelectAK()
 {
-	CurrentWeapon = 1;
-	CurrentFiringMode = 1;
+	EquipWeapon(1);
 }
 
 void AGameJam2Character::SelectSMG()
 {
-	CurrentWeapon = 2;
-	CurrentFiringMode = 1;
+	EquipWeapon(2);
 }
 
-void AGameJam2Character::Reload()
+void AGameJam2Character::SelectShotgun()
 {
-	bReloading = true;
-	GetWorld()->GetTimerManager().SetTimer(ReloadTimerHandle, this, &AGameJam2Character::ResetReloadTimer, ReloadSpeed, false);
+	EquipWeapon(3);
 }
 
+void AGameJam2Character::Reload()
+{
+	StartReload();
+}
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "WeaponDefinition.h"
 #include "GameJam2Character.generated.h"
 
 UCLASS(Blueprintable)
@@ -30,76 +31,96 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Shooting, meta = (AllowPrivateAccess = "true"))
 	UClass* CurrentProjectileClass;
 
-	//Set the firing mode (0 - Single fire, 1 - Automatic)
-	void setFiringMode(int mode);
+	//Weapon definitions, the index is the weapon id. Filled with the default weapons, or from WeaponTable when set
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Shooting, meta = (AllowPrivateAccess = "true"))
+	TArray<FWeaponDefinition> Weapons;
 
-	//Placeholder Variable for ammo, more will need to be added for different weapons
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = PlayerStats, meta = (AllowPrivateAccess = "true"))
-	int CurrentHealth = 100;
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = PlayerStats, meta = (AllowPrivateAccess = "true"))
-	int MaxHealth = 100;
+	//Optional data table of FWeaponDefinition rows that replaces Weapons at BeginPlay
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Shooting, meta = (AllowPrivateAccess = "true"))
+	class UDataTable* WeaponTable;
 
-	UFUNCTION(BlueprintCallable)
-	void ReceiveDamage(int ammount);
+	//Ammo for each weapon, indexed by weapon id
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Shooting, meta = (AllowPrivateAccess = "true"))
+	TArray<FWeaponState> WeaponStates;
 
+	//Switch to a weapon and resolve its projectile and sounds
 	UFUNCTION(BlueprintCallable)
-	void Die();
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = PlayerStats, meta = (AllowPrivateAccess = "true"))
-	bool bDead = false;
-
-	//Placeholder Variable for ammo, more will need to be added for different weapons
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Shooting, meta = (AllowPrivateAccess = "true"))
+	void EquipWeapon(int WeaponId);
+
+	//Ammo of the current weapon for the HUD
+	UFUNCTION(BlueprintPure)
+	int GetCurrentAmmo() const;
+	UFUNCTION(BlueprintPure)
+	int GetCurrentAmmoInClip() const;
+	UFUNCTION(BlueprintPure)
+	int GetCurrentMaxAmmo() const;
+	UFUNCTION(BlueprintPure)
+	int GetCurrentClipSize() const;
+
+	//Per weapon ammo kept for PlayerHUD's bindings, mirrored from WeaponStates for the pistol, AK and SMG
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Shooting, meta = (AllowPrivateAccess = "true"))
 	int CurrentPistolAmmo = 50;
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Shooting, meta = (AllowPrivateAccess = "true"))
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Shooting, meta = (AllowPrivateAccess = "true"))
 	int CurrentAKAmmo = 120;
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Shooting, meta = (AllowPrivateAccess = "true"))
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Shooting, meta = (AllowPrivateAccess = "true"))
 	int CurrentSMGAmmo = 80;
-
-	//Placeholder Variable for ammo, more will need to be added for different weapons
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Shooting, meta = (AllowPrivateAccess = "true"))
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Shooting, meta = (AllowPrivateAccess = "true"))
 	int CurrentPistolMaxAmmo = 50;
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Shooting, meta = (AllowPrivateAccess = "true"))
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Shooting, meta = (AllowPrivateAccess = "true"))
 	int CurrentAKMaxAmmo = 120;
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Shooting, meta = (AllowPrivateAccess = "true"))
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Shooting, meta = (AllowPrivateAccess = "true"))
 	int CurrentSMGMaxAmmo = 80;
-
-	//Placeholder Variable for Clip size, more will need to be added for different weapons
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Shooting, meta = (AllowPrivateAccess = "true"))
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Shooting, meta = (AllowPrivateAccess = "true"))
 	int CurrentPistolClipSize = 10;
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Shooting, meta = (AllowPrivateAccess = "true"))
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Shooting, meta = (AllowPrivateAccess = "true"))
 	int CurrentAKClipSize = 30;
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Shooting, meta = (AllowPrivateAccess = "true"))
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Shooting, meta = (AllowPrivateAccess = "true"))
 	int CurrentSMGClipSize = 20;
-
-	//Placeholder Variable for Clip size, more will need to be added for different weapons
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Shooting, meta = (AllowPrivateAccess = "true"))
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Shooting, meta = (AllowPrivateAccess = "true"))
 	int CurrentAmmoInPistolClip = 10;
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Shooting, meta = (AllowPrivateAccess = "true"))
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Shooting, meta = (AllowPrivateAccess = "true"))
 	int CurrentAmmoInAKClip = 30;
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Shooting, meta = (AllowPrivateAccess = "true"))
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Shooting, meta = (AllowPrivateAccess = "true"))
 	int CurrentAmmoInSMGClip = 20;
 
+	//Set the firing mode (0 - Single fire, 1 - Automatic)
+	void setFiringMode(int mode);
+
+	//Placeholder Variable for ammo, more will need to be added for different weapons
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = PlayerStats, meta = (AllowPrivateAccess = "true"))
+	int CurrentHealth = 100;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = PlayerStats, meta = (AllowPrivateAccess = "true"))
+	int MaxHealth = 100;
+
+	UFUNCTION(BlueprintCallable)
+	void ReceiveDamage(int ammount);
+
+	//Routes engine damage (simulated bullets, hitscan) into ReceiveDamage
+	virtual float TakeDamage(float DamageAmount, struct FDamageEvent const& DamageEvent, class AController* EventInstigator, AActor* DamageCauser) override;
+
+	UFUNCTION(BlueprintCallable)
+	void Die();
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = PlayerStats, meta = (AllowPrivateAccess = "true"))
+	bool bDead = false;
+
 	//Current firing mode
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Shooting, meta = (AllowPrivateAccess = "true"))
 	int CurrentWeapon = 0;
 	int CurrentFiringMode = 0;
 
 
-	//Used in timer to determine time between bullets
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Shooting, meta = (AllowPrivateAccess = "true"))
-	float ShootSpeed = 0.3;
-	float SMGShootSpeed = 0.05;
-	bool bShootOnCooldown;
-	FTimerHandle ShootSpeedTimerHandle;
-	void ResetShootSpeedTimer();
+	//Time from pressing shoot to the first bullet leaving the muzzle, in milliseconds
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Shooting, meta = (AllowPrivateAccess = "true"))
+	float LastFireLatencyMs = 0.f;
 
-	//Used in timer to determine time between bullets
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Shooting, meta = (AllowPrivateAccess = "true"))
-	float ReloadSpeed = 2;
+	//Used in timer to reload
 	bool bReloading;
 	FTimerHandle ReloadTimerHandle;
 	void ResetReloadTimer();
 
+	//Copy WeaponStates into the per weapon HUD properties
+	void UpdateHUDAmmo();
+
 	// helper variable for singe fire shooting
 	bool bShootOnce = true;
 
@@ -109,6 +130,12 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Sounds, meta = (AllowPrivateAccess = "true"))
 	class USoundBase* CurrentReloadSound;
 
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 private:
 	/** Top down camera */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
@@ -154,6 +181,45 @@ private:
 	/** Called whenever 3 is pressed to reload current weapon */
 	void Reload();
 
+	/** Called whenever 4 is pressed to select shotgun */
+	void SelectShotgun();
+
+	/** Fires every shot of the current weapon that falls due this frame */
+	void UpdateFiring(float DeltaSeconds);
+
+	/**
+	 * Fires a volley of the current weapon's pellets from the given muzzle transform as hitscan traces or through the projectile pool or simulation.
+	 * ShotAge is how long before the end of the frame the shot was due, bullets are moved on by that much.
+	 */
+	void FireProjectile(const FTransform& Muzzle, float ShotAge);
+
+	//Muzzle transform at the end of last frame, shots due mid frame are interpolated from it
+	FTransform LastMuzzleTransform;
+
+	//Whether the trigger was held with a weapon able to fire last frame
+	bool bFiringLastFrame = false;
+
+	//Platform time shoot was pressed, cleared once the first shot is fired
+	double ShootPressedTime = 0.0;
+
+	/** Fills PelletTransforms with one transform per pellet, spread around the muzzle transform */
+	void BuildVolley(const FWeaponDefinition& Weapon, const FTransform& Muzzle);
+
+	//Scratch for BuildVolley, kept so volleys don't allocate
+	TArray<FTransform> PelletTransforms;
+
+	//Counts volleys so seeded cones differ from shot to shot but replay the same way
+	int VolleyCount = 0;
+
+	/** Starts reloading the current weapon */
+	void StartReload();
+
+	//Resolved from the current weapon definition by EquipWeapon
+	bool bCurrentWeaponHitscan = false;
+	bool bCurrentWeaponSimulated = false;
+	float CurrentShootSpeed = 0.3f;
+	float CurrentReloadSpeed = 2.f;
+
 	//Shoot?
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Shooting, meta = (AllowPrivateAccess = "true"))
 	bool bShoot;
@@ -3,7 +3,7 @@
 #include "GameJam2GameMode.h"
 #include "GameJam2PlayerController.h"
 #include "GameJam2Character.h"
-#include "UObject/ConstructorHelpers.h"
+#include "GameFramework/DefaultPawn.h"
 
 AGameJam2GameMode::AGameJam2GameMode()
 {
@@ -11,9 +11,18 @@ AGameJam2GameMode::AGameJam2GameMode()
 	PlayerControllerClass = AGameJam2PlayerController::StaticClass();
 
 	// set default pawn class to our Blueprinted character
-	static ConstructorHelpers::FClassFinder<APawn> PlayerPawnBPClass(TEXT("/Game/TopDownCPP/Blueprints/TopDownCharacter"));
-	if (PlayerPawnBPClass.Class != NULL)
+	PlayerPawnClass = TSoftClassPtr<APawn>(FSoftObjectPath(TEXT("/Game/TopDownCPP/Blueprints/TopDownCharacter.TopDownCharacter_C")));
+}
+
+void AGameJam2GameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+	//Still part of the map load, before play begins, so this doesn't hitch the game.
+	//Game mode blueprints that pick their own pawn keep it
+	UClass* PawnClass = DefaultPawnClass == ADefaultPawn::StaticClass() ? PlayerPawnClass.LoadSynchronous() : nullptr;
+	if (PawnClass)
 	{
-		DefaultPawnClass = PlayerPawnBPClass.Class;
+		DefaultPawnClass = PawnClass;
 	}
-}
\ No newline at end of file
+
+	Super::InitGame(MapName, Options, ErrorMessage);
+}
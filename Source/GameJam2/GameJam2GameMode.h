@@ -6,13 +6,19 @@
 #include "GameFramework/GameModeBase.h"
 #include "GameJam2GameMode.generated.h"
 
-UCLASS(minimalapi)
+UCLASS(minimalapi, config = Game)
 class AGameJam2GameMode : public AGameModeBase
 {
 	GENERATED_BODY()
 
 public:
 	AGameJam2GameMode();
+
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+
+	//Blueprinted player character, loaded with the map instead of when the module starts
+	UPROPERTY(Config, EditDefaultsOnly, Category = Classes)
+	TSoftClassPtr<APawn> PlayerPawnClass;
 };
 
 
@@ -0,0 +1,231 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GunshotAudioSubsystem.h"
+#include "GameJam2.h"
+#include "Components/AudioComponent.h"
+#include "Sound/SoundBase.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/WorldSettings.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Gunshot Audio"), STAT_GunshotAudio, STATGROUP_GameJam2);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Gunshot Voices"), STAT_GunshotVoices, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Gunshots Played"), STAT_GunshotsPlayed, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Gunshots Culled"), STAT_GunshotsCulled, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Gunshots Coalesced"), STAT_GunshotsCoalesced, STATGROUP_GameJam2);
+
+void UGunshotAudioSubsystem::Deinitialize()
+{
+	for (UAudioComponent* Component : VoiceComponents)
+	{
+		if (Component)
+		{
+			Component->DestroyComponent();
+		}
+	}
+	VoiceComponents.Empty();
+	Voices.Empty();
+	SET_DWORD_STAT(STAT_GunshotVoices, 0);
+	Super::Deinitialize();
+}
+
+bool UGunshotAudioSubsystem::IsTickable() const
+{
+	return NumActiveVoices > 0;
+}
+
+ETickableTickType UGunshotAudioSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId UGunshotAudioSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UGunshotAudioSubsystem, STATGROUP_Tickables);
+}
+
+void UGunshotAudioSubsystem::Tick(float DeltaTime)
+{
+	//Hand back voices whose sound has finished, timed by the sound's duration so it works without an audio device
+	const float Now = GetWorld()->GetTimeSeconds();
+	for (int32 i = 0; i < Voices.Num(); i++)
+	{
+		if (Voices[i].bActive && Voices[i].EndTime <= Now)
+		{
+			StopVoice(i);
+		}
+	}
+}
+
+bool UGunshotAudioSubsystem::PlayGunshot(USoundBase* Sound, const FVector& Location)
+{
+	SCOPE_CYCLE_COUNTER(STAT_GunshotAudio);
+
+	if (!Sound)
+	{
+		return false;
+	}
+
+	FVector ListenerLocation;
+	if (GetListenerLocation(ListenerLocation) && FVector::DistSquared(ListenerLocation, Location) > FMath::Square(MaxAudibleDistance))
+	{
+		NumCulled++;
+		INC_DWORD_STAT(STAT_GunshotsCulled);
+		return false;
+	}
+
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	//Merge into a voice of the same sound that only just started nearby
+	for (int32 i = 0; i < Voices.Num(); i++)
+	{
+		FGunshotVoice& Voice = Voices[i];
+		if (Voice.bActive && Voice.Sound == Sound && Now - Voice.StartTime <= CoalesceWindow && FVector::DistSquared(Voice.Location, Location) <= FMath::Square(CoalesceRadius))
+		{
+			UAudioComponent* Component = VoiceComponents[i];
+			Component->SetVolumeMultiplier(FMath::Min(Component->VolumeMultiplier + CoalescedVolumeStep, MaxCoalescedVolume));
+			NumCoalesced++;
+			INC_DWORD_STAT(STAT_GunshotsCoalesced);
+			return false;
+		}
+	}
+
+	const int32 Index = FindVoice(Sound, Now);
+	if (Index == INDEX_NONE)
+	{
+		return false;
+	}
+	if (Voices[Index].bActive)
+	{
+		NumStolen++;
+		StopVoice(Index);
+	}
+
+	//Looping sounds report an effectively infinite duration, gunshots shouldn't loop so cap them
+	const float Duration = FMath::Min(Sound->GetDuration(), 10.f);
+
+	FGunshotVoice& Voice = Voices[Index];
+	Voice.Sound = Sound;
+	Voice.Location = Location;
+	Voice.StartTime = Now;
+	Voice.EndTime = Now + Duration;
+	Voice.bActive = true;
+	NumActiveVoices++;
+	INC_DWORD_STAT(STAT_GunshotVoices);
+
+	UAudioComponent* Component = VoiceComponents[Index];
+	Component->SetSound(Sound);
+	Component->SetWorldLocation(Location);
+	Component->SetVolumeMultiplier(1.f);
+	Component->Play();
+
+	NumPlayed++;
+	INC_DWORD_STAT(STAT_GunshotsPlayed);
+	return true;
+}
+
+int32 UGunshotAudioSubsystem::FindVoice(USoundBase* Sound, float Now)
+{
+	int32 FreeIndex = INDEX_NONE;
+	int32 OldestSameSound = INDEX_NONE;
+	int32 OldestAny = INDEX_NONE;
+	int32 SameSoundCount = 0;
+
+	for (int32 i = 0; i < Voices.Num(); i++)
+	{
+		const FGunshotVoice& Voice = Voices[i];
+		if (!Voice.bActive)
+		{
+			if (FreeIndex == INDEX_NONE)
+			{
+				FreeIndex = i;
+			}
+			continue;
+		}
+		if (Voice.Sound == Sound)
+		{
+			SameSoundCount++;
+			if (OldestSameSound == INDEX_NONE || Voice.StartTime < Voices[OldestSameSound].StartTime)
+			{
+				OldestSameSound = i;
+			}
+		}
+		if (OldestAny == INDEX_NONE || Voice.StartTime < Voices[OldestAny].StartTime)
+		{
+			OldestAny = i;
+		}
+	}
+
+	//Over this sound's limit, reuse its oldest voice
+	if (SameSoundCount >= MaxVoicesPerSound)
+	{
+		return OldestSameSound;
+	}
+	if (FreeIndex != INDEX_NONE)
+	{
+		return FreeIndex;
+	}
+
+	//Grow the pool up to its cap
+	if (Voices.Num() < MaxVoices)
+	{
+		if (UAudioComponent* Component = CreateVoiceComponent())
+		{
+			VoiceComponents.Add(Component);
+			return Voices.AddDefaulted();
+		}
+	}
+
+	//Pool is full, reuse the oldest voice of any sound
+	return OldestAny;
+}
+
+bool UGunshotAudioSubsystem::GetListenerLocation(FVector& OutLocation) const
+{
+	APlayerController* PC = GetWorld()->GetFirstPlayerController();
+	if (!PC)
+	{
+		return false;
+	}
+
+	FVector FrontDir, RightDir;
+	PC->GetAudioListenerPosition(OutLocation, FrontDir, RightDir);
+	return true;
+}
+
+UAudioComponent* UGunshotAudioSubsystem::CreateVoiceComponent()
+{
+	//The world settings actor is always around, so use it to own the pooled components
+	AWorldSettings* Owner = GetWorld()->GetWorldSettings();
+	if (!Owner)
+	{
+		return nullptr;
+	}
+
+	UAudioComponent* Component = NewObject<UAudioComponent>(Owner);
+	Component->bAutoActivate = false;
+	Component->bAutoDestroy = false;
+	Component->bAllowSpatialization = true;
+	Component->RegisterComponentWithWorld(GetWorld());
+	return Component;
+}
+
+void UGunshotAudioSubsystem::StopVoice(int32 Index)
+{
+	FGunshotVoice& Voice = Voices[Index];
+	if (!Voice.bActive)
+	{
+		return;
+	}
+
+	Voice.bActive = false;
+	Voice.Sound = nullptr;
+	NumActiveVoices--;
+	DEC_DWORD_STAT(STAT_GunshotVoices);
+
+	if (UAudioComponent* Component = VoiceComponents[Index])
+	{
+		Component->Stop();
+	}
+}
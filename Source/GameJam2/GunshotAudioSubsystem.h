@@ -0,0 +1,97 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "GunshotAudioSubsystem.generated.h"
+
+class UAudioComponent;
+class USoundBase;
+
+//Bookkeeping for one pooled audio component
+struct FGunshotVoice
+{
+	USoundBase* Sound = nullptr;
+	FVector Location = FVector::ZeroVector;
+	float StartTime = 0.f;
+	float EndTime = 0.f;
+	bool bActive = false;
+};
+
+/**
+ * Plays gunshot and reload sounds for every shooter through a fixed pool of audio components.
+ * Sounds out of earshot are culled, repeats of the same sound close together are merged into one voice
+ * and each sound has a voice limit, so audio cost stays flat however many characters are shooting.
+ * All the bookkeeping runs without an audio device, so it behaves the same with -nosound / -nullrhi.
+ */
+UCLASS(config = Game)
+class GAMEJAM2_API UGunshotAudioSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End FTickableGameObject interface
+
+	//Play a sound at a location, returns false if it was culled or merged into another voice
+	bool PlayGunshot(USoundBase* Sound, const FVector& Location);
+
+	//Sounds further than this from the listener are not played
+	UPROPERTY(Config)
+	float MaxAudibleDistance = 5000.f;
+
+	//Most voices one sound may have playing at once, the oldest is reused past this
+	UPROPERTY(Config)
+	int32 MaxVoicesPerSound = 6;
+
+	//Size of the audio component pool shared by all sounds
+	UPROPERTY(Config)
+	int32 MaxVoices = 32;
+
+	//Repeats of a sound started within this many seconds and CoalesceRadius of a playing voice are merged into it
+	UPROPERTY(Config)
+	float CoalesceWindow = 0.03f;
+
+	UPROPERTY(Config)
+	float CoalesceRadius = 200.f;
+
+	//Volume added to a voice per merged repeat, capped at MaxCoalescedVolume
+	UPROPERTY(Config)
+	float CoalescedVolumeStep = 0.15f;
+
+	UPROPERTY(Config)
+	float MaxCoalescedVolume = 1.5f;
+
+	//Counters
+	int32 NumPlayed = 0;
+	int32 NumCulled = 0;
+	int32 NumCoalesced = 0;
+	int32 NumStolen = 0;
+
+private:
+	//Index of a free voice, or of the voice to steal when none are free
+	int32 FindVoice(USoundBase* Sound, float Now);
+
+	bool GetListenerLocation(FVector& OutLocation) const;
+
+	UAudioComponent* CreateVoiceComponent();
+
+	void StopVoice(int32 Index);
+
+	//Pooled components, index matches Voices
+	UPROPERTY()
+	TArray<UAudioComponent*> VoiceComponents;
+
+	TArray<FGunshotVoice> Voices;
+
+	int32 NumActiveVoices = 0;
+};
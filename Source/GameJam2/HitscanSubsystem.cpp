@@ -0,0 +1,118 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HitscanSubsystem.h"
+#include "GameJam2.h"
+#include "BulletProjectile.h"
+#include "GameFramework/ProjectileMovementComponent.h"
+#include "GameFramework/Pawn.h"
+#include "Kismet/GameplayStatics.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Hitscan"), STAT_Hitscan, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hitscan Traces"), STAT_HitscanTraces, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hitscan Hits"), STAT_HitscanHits, STATGROUP_GameJam2);
+
+bool UHitscanSubsystem::IsTickable() const
+{
+	return PendingShots.Num() > 0 || InFlightShots.Num() > 0;
+}
+
+ETickableTickType UHitscanSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId UHitscanSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHitscanSubsystem, STATGROUP_Tickables);
+}
+
+void UHitscanSubsystem::GetShotStats(UClass* ProjectileClass, float& OutRange, float& OutDamage)
+{
+	OutRange = 9000.f;
+	OutDamage = 10.f;
+	if (ProjectileClass && ProjectileClass->IsChildOf(ABulletProjectile::StaticClass()))
+	{
+		const ABulletProjectile* Defaults = ProjectileClass->GetDefaultObject<ABulletProjectile>();
+		OutRange = Defaults->ProjectileMovement->InitialSpeed * Defaults->MaxLifeTime;
+		OutDamage = Defaults->Damage;
+	}
+}
+
+void UHitscanSubsystem::QueueShot(UClass* ProjectileClass, const FVector& Start, const FRotator& Rotation, AActor* Owner)
+{
+	float Range, Damage;
+	GetShotStats(ProjectileClass, Range, Damage);
+	QueueShot(Start, Start + Rotation.Vector() * Range, Damage, Owner);
+}
+
+void UHitscanSubsystem::QueueShots(UClass* ProjectileClass, TArrayView<const FTransform> Transforms, AActor* Owner)
+{
+	float Range, Damage;
+	GetShotStats(ProjectileClass, Range, Damage);
+	PendingShots.Reserve(PendingShots.Num() + Transforms.Num());
+	for (const FTransform& Transform : Transforms)
+	{
+		const FVector Start = Transform.GetLocation();
+		QueueShot(Start, Start + Transform.GetRotation().GetForwardVector() * Range, Damage, Owner);
+	}
+}
+
+void UHitscanSubsystem::QueueShot(const FVector& Start, const FVector& End, float Damage, AActor* Owner)
+{
+	FHitscanShot& Shot = PendingShots.AddDefaulted_GetRef();
+	Shot.Start = Start;
+	Shot.End = End;
+	Shot.Damage = Damage;
+	Shot.Owner = Owner;
+}
+
+void UHitscanSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_Hitscan);
+
+	ResolveShots();
+	IssueShots();
+}
+
+void UHitscanSubsystem::ResolveShots()
+{
+	UWorld* World = GetWorld();
+	for (const FHitscanShot& Shot : InFlightShots)
+	{
+		FTraceDatum Datum;
+		if (!World->QueryTraceData(Shot.Handle, Datum))
+		{
+			continue;
+		}
+
+		const FHitResult* Hit = FHitResult::GetFirstBlockingHit(Datum.OutHits);
+		AActor* HitActor = Hit ? Hit->GetActor() : nullptr;
+		if (!HitActor)
+		{
+			continue;
+		}
+
+		INC_DWORD_STAT(STAT_HitscanHits);
+		AActor* Owner = Shot.Owner.Get();
+		APawn* OwnerPawn = Cast<APawn>(Owner);
+		UGameplayStatics::ApplyPointDamage(HitActor, Shot.Damage, (Shot.End - Shot.Start).GetSafeNormal(), *Hit, OwnerPawn ? OwnerPawn->GetController() : nullptr, Owner, nullptr);
+	}
+	InFlightShots.Reset();
+}
+
+void UHitscanSubsystem::IssueShots()
+{
+	UWorld* World = GetWorld();
+	for (FHitscanShot& Shot : PendingShots)
+	{
+		FCollisionQueryParams Params(SCENE_QUERY_STAT(HitscanShot), false, Shot.Owner.Get());
+		Shot.Handle = World->AsyncLineTraceByChannel(EAsyncTraceType::Single, Shot.Start, Shot.End, TraceChannel, Params);
+	}
+	INC_DWORD_STAT_BY(STAT_HitscanTraces, PendingShots.Num());
+
+	//Swap so neither array reallocates from frame to frame
+	Swap(InFlightShots, PendingShots);
+	PendingShots.Reset();
+}
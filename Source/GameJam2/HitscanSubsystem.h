@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "WorldCollision.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HitscanSubsystem.generated.h"
+
+//A shot waiting for its trace to be issued or resolved
+struct FHitscanShot
+{
+	FVector Start;
+	FVector End;
+	float Damage;
+	TWeakObjectPtr<AActor> Owner;
+	FTraceHandle Handle;
+};
+
+/**
+ * Resolves hitscan shots for the player and AI.
+ * Shots queued during a frame are sent as one batch of async line traces at the end of the frame,
+ * and their hits are applied at the end of the next frame.
+ */
+UCLASS(config = Game)
+class GAMEJAM2_API UHitscanSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End FTickableGameObject interface
+
+	//Queue a shot using the damage and range (speed * lifetime) of a bullet class
+	void QueueShot(UClass* ProjectileClass, const FVector& Start, const FRotator& Rotation, AActor* Owner);
+
+	//Queue one shot per transform, looking the class stats up once
+	void QueueShots(UClass* ProjectileClass, TArrayView<const FTransform> Transforms, AActor* Owner);
+
+	//Queue a shot with explicit values
+	void QueueShot(const FVector& Start, const FVector& End, float Damage, AActor* Owner);
+
+	UPROPERTY(Config)
+	TEnumAsByte<ECollisionChannel> TraceChannel = ECC_Visibility;
+
+private:
+	//Damage and range (speed * lifetime) from a bullet class' defaults
+	static void GetShotStats(UClass* ProjectileClass, float& OutRange, float& OutDamage);
+
+	//Apply the results of the traces issued last frame
+	void ResolveShots();
+
+	//Issue this frame's shots as async traces
+	void IssueShots();
+
+	//Shots queued this frame
+	TArray<FHitscanShot> PendingShots;
+
+	//Shots whose traces were issued last frame
+	TArray<FHitscanShot> InFlightShots;
+};
@@ -3,50 +3,94 @@
 
 #include "InvisibleTrap.h"
 #include "GameJam2Character.h"
+#include "TrapSubsystem.h"
 
 // Sets default values
 AInvisibleTrap::AInvisibleTrap()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+ 	// Overlaps are found by the trap subsystem, traps never tick
+	PrimaryActorTick.bCanEverTick = false;
 
 	TrapBase = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("Trap Base"));
 	TrapBase->SetupAttachment(RootComponent);
+	TrapBase->SetGenerateOverlapEvents(false);
 
 	TrapAnimatedMesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("Trap Animated Mesh"));
 	TrapAnimatedMesh->SetupAttachment(TrapBase);
 	TrapAnimatedMesh->SetRelativeLocation(FVector(0.f, 0.f, 0.f));
+	TrapAnimatedMesh->SetGenerateOverlapEvents(false);
 
 	CollisionMeshComponent = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("Collision Mesh Comp"));
 	CollisionMeshComponent->SetupAttachment(TrapBase);
 	CollisionMeshComponent->SetRelativeLocation(FVector(0.f, 0.f, 0.f));
-
-	//Register OnBeginOverlap function as an OnActorBeginOverlap delegate
-	OnActorBeginOverlap.AddDynamic(this, &AInvisibleTrap::OnBeginOverlap);
+	CollisionMeshComponent->SetGenerateOverlapEvents(false);
 }
 
 // Called when the game starts or when spawned
 void AInvisibleTrap::BeginPlay()
 {
 	Super::BeginPlay();
-	TrapBase->SetMaterial(0, Semi);
-	TrapAnimatedMesh->SetMaterial(0, Invisible);
+
+	//Materials are set once, revealing only changes the custom data
+	if (RevealMaterial)
+	{
+		TrapBase->SetMaterial(0, RevealMaterial);
+		TrapAnimatedMesh->SetMaterial(0, RevealMaterial);
+		TrapBase->SetCustomPrimitiveDataFloat(1, BaseHiddenVisibility);
+		TrapAnimatedMesh->SetCustomPrimitiveDataFloat(1, AnimatedHiddenVisibility);
+	}
+	else
+	{
+		TrapBase->SetMaterial(0, Semi);
+		TrapAnimatedMesh->SetMaterial(0, Invisible);
+	}
+
+	if (UTrapSubsystem* Traps = GetWorld()->GetSubsystem<UTrapSubsystem>())
+	{
+		Traps->RegisterTrap(this);
+	}
 }
 
-// Called every frame
-void AInvisibleTrap::Tick(float DeltaTime)
+void AInvisibleTrap::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	Super::Tick(DeltaTime);
+	if (UTrapSubsystem* Traps = GetWorld()->GetSubsystem<UTrapSubsystem>())
+	{
+		Traps->UnregisterTrap(this);
+	}
+	Super::EndPlay(EndPlayReason);
+}
 
+FBox AInvisibleTrap::GetTriggerBounds() const
+{
+	return CollisionMeshComponent->Bounds.GetBox();
 }
 
-void AInvisibleTrap::OnBeginOverlap(AActor* OverlappedActor, AActor* OtherActor)
+void AInvisibleTrap::Reveal()
 {
-	if (OtherActor->ActorHasTag("Player")) {
+	if (bRevealed)
+	{
+		return;
+	}
+	bRevealed = true;
+
+	if (RevealMaterial)
+	{
+		TrapBase->SetCustomPrimitiveDataFloat(0, 1.f);
+		TrapAnimatedMesh->SetCustomPrimitiveDataFloat(0, 1.f);
+	}
+	else
+	{
 		TrapBase->SetMaterial(0, Visible);
 		TrapAnimatedMesh->SetMaterial(0, Visible);
-		AGameJam2Character* player = Cast<AGameJam2Character>(OtherActor);
-		player->ReceiveDamage(this->DamageGiven);
 	}
 }
 
+void AInvisibleTrap::OnPlayerEnter(APawn* Player)
+{
+	if (Player->ActorHasTag("Player")) {
+		Reveal();
+		if (AGameJam2Character* Character = Cast<AGameJam2Character>(Player)) {
+			Character->ReceiveDamage(this->DamageGiven);
+		}
+	}
+}
@@ -19,10 +19,9 @@ protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
-public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
+public:	
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Mesh, meta = (AllowPrivateAccess = "true"))
 		UMaterial* Invisible;
 
@@ -32,13 +31,28 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Mesh, meta = (AllowPrivateAccess = "true"))
 		UMaterial* Semi;
 
+	//One material for both meshes that reads custom primitive data: 0 is how revealed the trap is, 1 how visible it is while hidden.
+	//When set the trap is revealed by changing that data instead of swapping to the Visible material
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Mesh, meta = (AllowPrivateAccess = "true"))
+		UMaterialInterface* RevealMaterial;
+
+	//Visibility of each mesh before the trap is revealed, with RevealMaterial
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Mesh, meta = (AllowPrivateAccess = "true"))
+		float BaseHiddenVisibility = 0.5f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Mesh, meta = (AllowPrivateAccess = "true"))
+		float AnimatedHiddenVisibility = 0.f;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = TrapStats, meta = (AllowPrivateAccess = "true"))
 		int DamageGiven = 100;
 
-	//The delegate function for handling an overlap event
-	UFUNCTION()
-		void OnBeginOverlap(AActor* OverlappedActor, AActor* OtherActor);
+	//Called by the trap subsystem when the player steps into the trap
+	void OnPlayerEnter(APawn* Player);
+
+	//World space box the player has to touch to set the trap off
+	FBox GetTriggerBounds() const;
+
 private:
+	void Reveal();
 
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Mesh, meta = (AllowPrivateAccess = "true"))
 		UStaticMeshComponent* TrapBase;
@@ -49,4 +63,5 @@ private:
 	UPROPERTY(EditAnywhere)
 		class UStaticMeshComponent* CollisionMeshComponent;
 
+	bool bRevealed = false;
 };
@@ -6,6 +6,8 @@
 #include "BehaviorTree/BehaviorTreeComponent.h"
 #include "BehaviorTree/BlackboardComponent.h"
 #include "BehaviorTree/BehaviorTree.h"
+#include "BehaviorTree/Blackboard/BlackboardKeyType_Object.h"
+#include "AIFireControlSubsystem.h"
 
 AMyAIController::AMyAIController()
 {
@@ -24,6 +26,9 @@ void AMyAIController::OnPossess(APawn* pawn) {
 	if (AICharacter) {
 		if (AICharacter->BehaviorTree->BlackboardAsset) {
 			BlackboardComp->InitializeBlackboard(*(AICharacter->BehaviorTree->BlackboardAsset));
+			TargetKeyId = BlackboardComp->GetKeyID(BlackboardKey);
+			//Registered as the controller's brain, so pausing, resuming and throttling the logic reach the tree
+			BrainComponent = BehaviorComp;
 			BehaviorComp->StartTree(*AICharacter->BehaviorTree);
 		}
 	}
@@ -32,7 +37,25 @@ void AMyAIController::OnPossess(APawn* pawn) {
 void AMyAIController::SetSeenTarget(APawn* pawn)
 {
 
-	if (BlackboardComp) {
-		BlackboardComp->SetValueAsObject(BlackboardKey, pawn);
+	if (BlackboardComp && TargetKeyId != FBlackboard::InvalidKey) {
+		BlackboardComp->SetValue<UBlackboardKeyType_Object>(TargetKeyId, pawn);
 	}
+
+	//Having a target is what makes an enemy worth considering for firing
+	if (pawn)
+	{
+		if (UAIFireControlSubsystem* FireControl = GetWorld()->GetSubsystem<UAIFireControlSubsystem>())
+		{
+			FireControl->Engage(Cast<AAICharacter>(GetPawn()));
+		}
+	}
+}
+
+AActor* AMyAIController::GetSeenTarget() const
+{
+	if (!BlackboardComp || TargetKeyId == FBlackboard::InvalidKey)
+	{
+		return nullptr;
+	}
+	return Cast<AActor>(BlackboardComp->GetValue<UBlackboardKeyType_Object>(TargetKeyId));
 }
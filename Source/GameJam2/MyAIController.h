@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "AIController.h"
 #include "BehaviorTree/BehaviorTreeComponent.h"
+#include "BehaviorTree/BehaviorTreeTypes.h"
 #include "MyAIController.generated.h"
 
 /**
@@ -29,4 +30,11 @@ public:
 	virtual void OnPossess(APawn* Pawn) override;
 
 	void SetSeenTarget(APawn* Pawn);
+
+	//Current blackboard Target, or null
+	AActor* GetSeenTarget() const;
+
+private:
+	//Key ID resolved once when the blackboard is set up, so writes skip the name lookup
+	FBlackboard::FKey TargetKeyId = FBlackboard::InvalidKey;
 };
@@ -0,0 +1,330 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PawnPerceptionSubsystem.h"
+#include "GameJam2.h"
+#include "AICharacter.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Perception"), STAT_Perception, STATGROUP_GameJam2);
+DECLARE_CYCLE_STAT(TEXT("Perception Hash"), STAT_PerceptionHash, STATGROUP_GameJam2);
+DECLARE_CYCLE_STAT(TEXT("Perception Cones"), STAT_PerceptionCones, STATGROUP_GameJam2);
+DECLARE_CYCLE_STAT(TEXT("Perception Traces"), STAT_PerceptionTraces, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Perception Traces Per Frame"), STAT_PerceptionTraceCount, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Perception Queued Checks"), STAT_PerceptionQueued, STATGROUP_GameJam2);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Perception Latency (s)"), STAT_PerceptionLatency, STATGROUP_GameJam2);
+
+bool UPawnPerceptionSubsystem::IsTickable() const
+{
+	return Observers.Num() > 0;
+}
+
+ETickableTickType UPawnPerceptionSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId UPawnPerceptionSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UPawnPerceptionSubsystem, STATGROUP_Tickables);
+}
+
+void UPawnPerceptionSubsystem::RegisterPawn(APawn* Pawn, bool bIsPlayer)
+{
+	if (Pawn && !Pawns.Contains(Pawn))
+	{
+		Pawns.Add(Pawn);
+		PawnIsPlayer.Add(bIsPlayer);
+	}
+}
+
+void UPawnPerceptionSubsystem::UnregisterPawn(APawn* Pawn)
+{
+	const int32 Index = Pawns.IndexOfByKey(Pawn);
+	if (Index != INDEX_NONE)
+	{
+		Pawns.RemoveAtSwap(Index);
+		PawnIsPlayer.RemoveAtSwap(Index);
+	}
+}
+
+void UPawnPerceptionSubsystem::RegisterObserver(AAICharacter* Observer)
+{
+	if (Observer)
+	{
+		Observers.AddUnique(Observer);
+	}
+}
+
+void UPawnPerceptionSubsystem::UnregisterObserver(AAICharacter* Observer)
+{
+	Observers.RemoveSwap(Observer);
+
+	//Checks already queued would still report sightings from a corpse or a dormant pooled enemy
+	PendingChecks.RemoveAll([this, Observer](const FPendingSightCheck& Check)
+	{
+		if (Check.Observer == Observer)
+		{
+			PairCooldowns.Remove(Check.PairKey);
+			return true;
+		}
+		return false;
+	});
+}
+
+void UPawnPerceptionSubsystem::GetPawnsInRadius(const FVector& Location, float Radius, TArray<APawn*>& OutPawns) const
+{
+	const int32 MinX = FMath::FloorToInt((Location.X - Radius) / CellSize);
+	const int32 MaxX = FMath::FloorToInt((Location.X + Radius) / CellSize);
+	const int32 MinY = FMath::FloorToInt((Location.Y - Radius) / CellSize);
+	const int32 MaxY = FMath::FloorToInt((Location.Y + Radius) / CellSize);
+	const float RadiusSq = FMath::Square(Radius);
+
+	for (int32 X = MinX; X <= MaxX; X++)
+	{
+		for (int32 Y = MinY; Y <= MaxY; Y++)
+		{
+			const TArray<int32>* Cell = Cells.Find(CellKey(X, Y));
+			if (!Cell)
+			{
+				continue;
+			}
+			for (int32 PawnIndex : *Cell)
+			{
+				APawn* Pawn = Pawns[PawnIndex].Get();
+				if (Pawn && FVector::DistSquared(PawnLocations[PawnIndex], Location) <= RadiusSq)
+				{
+					OutPawns.Add(Pawn);
+				}
+			}
+		}
+	}
+}
+
+void UPawnPerceptionSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_Perception);
+
+	const float Now = GetWorld()->GetTimeSeconds();
+	RebuildHash();
+	TestVisionCones(Now);
+	ProcessSightChecks(Now);
+}
+
+void UPawnPerceptionSubsystem::RebuildHash()
+{
+	SCOPE_CYCLE_COUNTER(STAT_PerceptionHash);
+
+	//Empty the cells but keep their allocations, most pawns stay in the same cells frame to frame
+	for (auto& Pair : Cells)
+	{
+		Pair.Value.Reset();
+	}
+
+	for (int32 i = Pawns.Num() - 1; i >= 0; i--)
+	{
+		if (!Pawns[i].IsValid())
+		{
+			Pawns.RemoveAtSwap(i, 1, false);
+			PawnIsPlayer.RemoveAtSwap(i, 1, false);
+		}
+	}
+
+	PawnLocations.SetNumUninitialized(Pawns.Num(), false);
+	for (int32 i = 0; i < Pawns.Num(); i++)
+	{
+		const FVector Location = Pawns[i]->GetActorLocation();
+		PawnLocations[i] = Location;
+		Cells.FindOrAdd(CellKey(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize))).Add(i);
+	}
+}
+
+void UPawnPerceptionSubsystem::TestVisionCones(float Now)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PerceptionCones);
+
+	PairObserver.Reset();
+	PairPawn.Reset();
+	PairDX.Reset();
+	PairDY.Reset();
+	PairDZ.Reset();
+	PairFX.Reset();
+	PairFY.Reset();
+	PairFZ.Reset();
+	PairRadiusSq.Reset();
+	PairCos.Reset();
+
+	//Drop dead observers before pairing, so the observer indices stored per pair stay valid
+	for (int32 o = Observers.Num() - 1; o >= 0; o--)
+	{
+		if (!Observers[o].IsValid())
+		{
+			Observers.RemoveAtSwap(o, 1, false);
+		}
+	}
+
+	//Gather pairs from the cells each observer's sight radius touches
+	for (int32 o = 0; o < Observers.Num(); o++)
+	{
+		AAICharacter* Observer = Observers[o].Get();
+
+		//Low detail enemies only look around every PerceptionUpdateInterval seconds
+		if (Now < Observer->NextPerceptionTime)
+		{
+			continue;
+		}
+		Observer->NextPerceptionTime = Now + Observer->PerceptionUpdateInterval;
+
+		const FVector Location = Observer->GetActorLocation();
+		const FVector Forward = Observer->GetActorForwardVector();
+		const float Radius = Observer->SightRadius;
+		const float Cos = FMath::Cos(FMath::DegreesToRadians(Observer->PeripheralVisionAngle));
+		const int32 MinX = FMath::FloorToInt((Location.X - Radius) / CellSize);
+		const int32 MaxX = FMath::FloorToInt((Location.X + Radius) / CellSize);
+		const int32 MinY = FMath::FloorToInt((Location.Y - Radius) / CellSize);
+		const int32 MaxY = FMath::FloorToInt((Location.Y + Radius) / CellSize);
+
+		for (int32 X = MinX; X <= MaxX; X++)
+		{
+			for (int32 Y = MinY; Y <= MaxY; Y++)
+			{
+				const TArray<int32>* Cell = Cells.Find(CellKey(X, Y));
+				if (!Cell)
+				{
+					continue;
+				}
+				for (int32 PawnIndex : *Cell)
+				{
+					if ((bOnlySensePlayers && !PawnIsPlayer[PawnIndex]) || Pawns[PawnIndex] == Observer)
+					{
+						continue;
+					}
+					const FVector Delta = PawnLocations[PawnIndex] - Location;
+					PairObserver.Add(o);
+					PairPawn.Add(PawnIndex);
+					PairDX.Add(Delta.X);
+					PairDY.Add(Delta.Y);
+					PairDZ.Add(Delta.Z);
+					PairFX.Add(Forward.X);
+					PairFY.Add(Forward.Y);
+					PairFZ.Add(Forward.Z);
+					PairRadiusSq.Add(Radius * Radius);
+					PairCos.Add(Cos);
+				}
+			}
+		}
+	}
+
+	//In cone when within the sight radius and Forward . Delta > Cos * |Delta|, 4 pairs at a time
+	const int32 NumPairs = PairObserver.Num();
+	PairInCone.SetNumUninitialized(NumPairs, false);
+	const int32 NumVectorized = NumPairs & ~3;
+	for (int32 i = 0; i < NumVectorized; i += 4)
+	{
+		const VectorRegister DX = VectorLoad(&PairDX[i]);
+		const VectorRegister DY = VectorLoad(&PairDY[i]);
+		const VectorRegister DZ = VectorLoad(&PairDZ[i]);
+		const VectorRegister DistSq = VectorMultiplyAdd(DX, DX, VectorMultiplyAdd(DY, DY, VectorMultiply(DZ, DZ)));
+		const VectorRegister Dot = VectorMultiplyAdd(VectorLoad(&PairFX[i]), DX, VectorMultiplyAdd(VectorLoad(&PairFY[i]), DY, VectorMultiply(VectorLoad(&PairFZ[i]), DZ)));
+		const VectorRegister Dist = VectorMultiply(DistSq, VectorReciprocalSqrtAccurate(DistSq));
+		const VectorRegister InRange = VectorCompareGE(VectorLoad(&PairRadiusSq[i]), DistSq);
+		const VectorRegister InAngle = VectorCompareGT(Dot, VectorMultiply(VectorLoad(&PairCos[i]), Dist));
+		const int32 Mask = VectorMaskBits(VectorBitwiseAnd(InRange, InAngle));
+		PairInCone[i] = (Mask >> 0) & 1;
+		PairInCone[i + 1] = (Mask >> 1) & 1;
+		PairInCone[i + 2] = (Mask >> 2) & 1;
+		PairInCone[i + 3] = (Mask >> 3) & 1;
+	}
+	for (int32 i = NumVectorized; i < NumPairs; i++)
+	{
+		const float DistSq = PairDX[i] * PairDX[i] + PairDY[i] * PairDY[i] + PairDZ[i] * PairDZ[i];
+		const float Dot = PairFX[i] * PairDX[i] + PairFY[i] * PairDY[i] + PairFZ[i] * PairDZ[i];
+		PairInCone[i] = DistSq <= PairRadiusSq[i] && Dot > PairCos[i] * FMath::Sqrt(DistSq) ? 1 : 0;
+	}
+
+	//Queue a line of sight check for pairs in a cone that aren't already queued or recently checked
+	for (int32 i = 0; i < NumPairs; i++)
+	{
+		if (!PairInCone[i])
+		{
+			continue;
+		}
+
+		AAICharacter* Observer = Observers[PairObserver[i]].Get();
+		APawn* Pawn = Pawns[PairPawn[i]].Get();
+		if (!Observer || !Pawn)
+		{
+			continue;
+		}
+		const uint64 Key = (uint64(Observer->GetUniqueID()) << 32) | uint64(Pawn->GetUniqueID());
+		float& Cooldown = PairCooldowns.FindOrAdd(Key, 0.f);
+		if (Cooldown > Now)
+		{
+			continue;
+		}
+
+		//Queued pairs wait until their trace runs
+		Cooldown = MAX_flt;
+		FPendingSightCheck& Check = PendingChecks.AddDefaulted_GetRef();
+		Check.Observer = Observer;
+		Check.Target = Pawn;
+		Check.PairKey = Key;
+		Check.EnterTime = Now;
+	}
+}
+
+void UPawnPerceptionSubsystem::ProcessSightChecks(float Now)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PerceptionTraces);
+
+	UWorld* World = GetWorld();
+	int32 NumProcessed = 0;
+	int32 NumTraces = 0;
+	int32 NumSeen = 0;
+	float TotalLatency = 0.f;
+
+	while (NumProcessed < PendingChecks.Num() && NumTraces < MaxTracesPerFrame)
+	{
+		const FPendingSightCheck& Check = PendingChecks[NumProcessed++];
+		AAICharacter* Observer = Check.Observer.Get();
+		APawn* Target = Check.Target.Get();
+		if (!Observer || !Target || Observer->IsDead() || Observer->IsDormant())
+		{
+			PairCooldowns.Remove(Check.PairKey);
+			continue;
+		}
+
+		FCollisionQueryParams Params(SCENE_QUERY_STAT(PerceptionLineOfSight), true, Observer);
+		Params.AddIgnoredActor(Target);
+		const bool bBlocked = World->LineTraceTestByChannel(Observer->GetPawnViewLocation(), Target->GetActorLocation(), LineOfSightChannel, Params);
+		NumTraces++;
+
+		//Seen or not, don't look at this pair again until the observer's next sensing interval
+		PairCooldowns.Add(Check.PairKey, Now + Observer->SensingInterval);
+		if (!bBlocked)
+		{
+			NumSeen++;
+			TotalLatency += Now - Check.EnterTime;
+			Observer->OnSeePawn.Broadcast(Target);
+		}
+	}
+	PendingChecks.RemoveAt(0, NumProcessed, false);
+
+	//Forget pairs whose cooldown has run out so the map doesn't grow forever
+	for (auto It = PairCooldowns.CreateIterator(); It; ++It)
+	{
+		if (It.Value() <= Now)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	LastTraceCount = NumTraces;
+	if (NumSeen > 0)
+	{
+		LastPerceptionLatency = TotalLatency / NumSeen;
+	}
+	SET_DWORD_STAT(STAT_PerceptionTraceCount, NumTraces);
+	SET_DWORD_STAT(STAT_PerceptionQueued, PendingChecks.Num());
+	SET_FLOAT_STAT(STAT_PerceptionLatency, LastPerceptionLatency);
+}
@@ -0,0 +1,111 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "PawnPerceptionSubsystem.generated.h"
+
+class AAICharacter;
+
+//A sight check waiting for its line of sight trace
+struct FPendingSightCheck
+{
+	TWeakObjectPtr<AAICharacter> Observer;
+	TWeakObjectPtr<APawn> Target;
+	uint64 PairKey = 0;
+	float EnterTime = 0.f;
+};
+
+/**
+ * Sight for every enemy in one place, replacing a UPawnSensingComponent per enemy.
+ * All pawns live in a uniform spatial hash. Each frame the vision cones of every enemy are tested against
+ * the pawns in nearby cells in one vectorized pass, and the line of sight traces for the pawns inside a cone
+ * are spread over frames with a fixed trace budget. Seen pawns are reported through AAICharacter::OnSeePawn.
+ */
+UCLASS(config = Game)
+class GAMEJAM2_API UPawnPerceptionSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End FTickableGameObject interface
+
+	//Pawns that can be seen
+	void RegisterPawn(APawn* Pawn, bool bIsPlayer);
+	void UnregisterPawn(APawn* Pawn);
+
+	//Enemies that look for pawns
+	void RegisterObserver(AAICharacter* Observer);
+	void UnregisterObserver(AAICharacter* Observer);
+
+	//Registered pawns within Radius of Location, from the spatial hash as of the last update
+	void GetPawnsInRadius(const FVector& Location, float Radius, TArray<APawn*>& OutPawns) const;
+
+	//Size of a spatial hash cell
+	UPROPERTY(Config)
+	float CellSize = 1000.f;
+
+	//Line of sight traces allowed per frame, the rest wait in a queue
+	UPROPERTY(Config)
+	int32 MaxTracesPerFrame = 16;
+
+	//Like UPawnSensingComponent::bOnlySensePlayers
+	UPROPERTY(Config)
+	bool bOnlySensePlayers = true;
+
+	UPROPERTY(Config)
+	TEnumAsByte<ECollisionChannel> LineOfSightChannel = ECC_Visibility;
+
+	//Counters from the last update
+	int32 LastTraceCount = 0;
+	float LastPerceptionLatency = 0.f;
+
+private:
+	static uint64 CellKey(int32 X, int32 Y) { return (uint64(uint32(X)) << 32) | uint64(uint32(Y)); }
+
+	//Copy pawn positions and bucket them into cells
+	void RebuildHash();
+
+	//Find every observer/pawn pair close enough to test, then test them all against the vision cones
+	void TestVisionCones(float Now);
+
+	//Run up to MaxTracesPerFrame queued line of sight checks
+	void ProcessSightChecks(float Now);
+
+	//Registered pawns, positions are copied into PawnLocations each update
+	TArray<TWeakObjectPtr<APawn>> Pawns;
+	TArray<bool> PawnIsPlayer;
+	TArray<FVector> PawnLocations;
+
+	TArray<TWeakObjectPtr<AAICharacter>> Observers;
+
+	//Cell -> indices into Pawns
+	TMap<uint64, TArray<int32>> Cells;
+
+	//Candidate pairs for the cone test, structure of arrays so it can be done 4 at a time
+	TArray<int32> PairObserver;
+	TArray<int32> PairPawn;
+	TArray<float> PairDX;
+	TArray<float> PairDY;
+	TArray<float> PairDZ;
+	TArray<float> PairFX;
+	TArray<float> PairFY;
+	TArray<float> PairFZ;
+	TArray<float> PairRadiusSq;
+	TArray<float> PairCos;
+	TArray<uint8> PairInCone;
+
+	//Line of sight checks waiting for trace budget, oldest first
+	TArray<FPendingSightCheck> PendingChecks;
+
+	//Observer/pawn pair -> time it may be queued again (while queued or recently seen)
+	TMap<uint64, float> PairCooldowns;
+};
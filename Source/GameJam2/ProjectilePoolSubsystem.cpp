@@ -0,0 +1,159 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ProjectilePoolSubsystem.h"
+#include "GameJam2.h"
+#include "BulletProjectile.h"
+#include "GameFramework/ProjectileMovementComponent.h"
+#include "Engine/World.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Projectile Pool Hits"), STAT_ProjectilePoolHits, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Projectile Pool Misses"), STAT_ProjectilePoolMisses, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Projectile Pool Overflows"), STAT_ProjectilePoolOverflows, STATGROUP_GameJam2);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pooled Projectiles"), STAT_PooledProjectiles, STATGROUP_GameJam2);
+
+void UProjectilePoolSubsystem::Deinitialize()
+{
+	for (auto& Pair : Pools)
+	{
+		DEC_DWORD_STAT_BY(STAT_PooledProjectiles, Pair.Value.AllProjectiles.Num());
+	}
+	Pools.Empty();
+	Super::Deinitialize();
+}
+
+void UProjectilePoolSubsystem::PrewarmPool(UClass* ProjectileClass, int32 Count)
+{
+	if (!ProjectileClass || !ProjectileClass->IsChildOf(ABulletProjectile::StaticClass()))
+	{
+		return;
+	}
+
+	FProjectilePool& Pool = Pools.FindOrAdd(ProjectileClass);
+	const int32 Target = FMath::Min(Count < 0 ? PrewarmCount : Count, HighWaterMark);
+	while (Pool.AllProjectiles.Num() < Target)
+	{
+		ABulletProjectile* Projectile = SpawnPooledProjectile(ProjectileClass, Pool);
+		if (!Projectile)
+		{
+			break;
+		}
+		Pool.FreeProjectiles.Add(Projectile);
+	}
+}
+
+AActor* UProjectilePoolSubsystem::AcquireProjectile(UClass* ProjectileClass, const FVector& Location, const FRotator& Rotation, AActor* Owner, float SubFrameAge)
+{
+	UWorld* World = GetWorld();
+	if (!ProjectileClass || !World)
+	{
+		return nullptr;
+	}
+
+	//Not a pooled bullet type, fall back to a normal spawn
+	if (!ProjectileClass->IsChildOf(ABulletProjectile::StaticClass()))
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.Owner = Owner;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		return World->SpawnActor<AActor>(ProjectileClass, Location, Rotation, SpawnParams);
+	}
+
+	FProjectilePool& Pool = Pools.FindOrAdd(ProjectileClass);
+	ABulletProjectile* Projectile = nullptr;
+
+	//Dormant bullets can be destroyed from outside (level unload, blueprint calling DestroyActor)
+	while (!Projectile && Pool.FreeProjectiles.Num() > 0)
+	{
+		Projectile = Pool.FreeProjectiles.Pop(false);
+		if (!IsValid(Projectile))
+		{
+			Pool.AllProjectiles.RemoveSwap(Projectile);
+			DEC_DWORD_STAT(STAT_PooledProjectiles);
+			Projectile = nullptr;
+		}
+	}
+
+	if (Projectile)
+	{
+		PoolHits++;
+		INC_DWORD_STAT(STAT_ProjectilePoolHits);
+	}
+	else if (Pool.AllProjectiles.Num() < HighWaterMark)
+	{
+		PoolMisses++;
+		INC_DWORD_STAT(STAT_ProjectilePoolMisses);
+		Projectile = SpawnPooledProjectile(ProjectileClass, Pool);
+	}
+	else
+	{
+		//Pool is full, spawn a one off bullet that destroys itself
+		PoolOverflows++;
+		INC_DWORD_STAT(STAT_ProjectilePoolOverflows);
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.Owner = Owner;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		Projectile = World->SpawnActor<ABulletProjectile>(ProjectileClass, Location, Rotation, SpawnParams);
+	}
+
+	if (Projectile)
+	{
+		Projectile->ActivateProjectile(Location, Rotation, Owner, SubFrameAge);
+	}
+	return Projectile;
+}
+
+void UProjectilePoolSubsystem::AcquireProjectiles(UClass* ProjectileClass, TArrayView<const FTransform> Transforms, AActor* Owner, float SubFrameAge)
+{
+	//Top the pool up in one go so a big volley doesn't miss once per pellet
+	if (FProjectilePool* Pool = Pools.Find(ProjectileClass))
+	{
+		if (Pool->FreeProjectiles.Num() < Transforms.Num())
+		{
+			PrewarmPool(ProjectileClass, Pool->AllProjectiles.Num() - Pool->FreeProjectiles.Num() + Transforms.Num());
+		}
+	}
+
+	for (const FTransform& Transform : Transforms)
+	{
+		AcquireProjectile(ProjectileClass, Transform.GetLocation(), Transform.Rotator(), Owner, SubFrameAge);
+	}
+}
+
+void UProjectilePoolSubsystem::ReleaseProjectile(ABulletProjectile* Projectile, bool bHit)
+{
+	if (!Projectile || !Projectile->IsProjectileActive())
+	{
+		return;
+	}
+
+	if (bHit)
+	{
+		ImpactReturns++;
+	}
+	else
+	{
+		ExpiredReturns++;
+	}
+
+	Projectile->DeactivateProjectile();
+	if (FProjectilePool* Pool = Pools.Find(Projectile->GetClass()))
+	{
+		Pool->FreeProjectiles.Add(Projectile);
+	}
+}
+
+ABulletProjectile* UProjectilePoolSubsystem::SpawnPooledProjectile(UClass* ProjectileClass, FProjectilePool& Pool)
+{
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	ABulletProjectile* Projectile = GetWorld()->SpawnActor<ABulletProjectile>(ProjectileClass, FVector::ZeroVector, FRotator::ZeroRotator, SpawnParams);
+	if (Projectile)
+	{
+		Projectile->OwningPool = this;
+		Projectile->DeactivateProjectile();
+		Pool.AllProjectiles.Add(Projectile);
+		INC_DWORD_STAT(STAT_PooledProjectiles);
+	}
+	return Projectile;
+}
@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ProjectilePoolSubsystem.generated.h"
+
+class ABulletProjectile;
+
+//All the bullets of one projectile class
+USTRUCT()
+struct FProjectilePool
+{
+	GENERATED_BODY()
+
+	//Every bullet this pool owns, active or not
+	UPROPERTY()
+	TArray<ABulletProjectile*> AllProjectiles;
+
+	//Dormant bullets ready to be handed out
+	UPROPERTY()
+	TArray<ABulletProjectile*> FreeProjectiles;
+};
+
+/**
+ * Hands out bullets for the player and AI fire paths, recycling them instead of spawning and destroying an actor per shot.
+ * Classes that don't derive from ABulletProjectile can't be recycled and are spawned normally.
+ */
+UCLASS(config = Game)
+class GAMEJAM2_API UProjectilePoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	//Spawn dormant bullets until the pool for this class holds at least Count (PrewarmCount if negative)
+	void PrewarmPool(UClass* ProjectileClass, int32 Count = -1);
+
+	//Fire a bullet of the given class from the given transform, SubFrameAge seconds ago
+	AActor* AcquireProjectile(UClass* ProjectileClass, const FVector& Location, const FRotator& Rotation, AActor* Owner, float SubFrameAge = 0.f);
+
+	//Fire one bullet per transform, e.g. all the pellets of a shotgun volley.
+	//SubFrameAge is how long before the end of the frame they were fired, the bullets are swept on by that much
+	void AcquireProjectiles(UClass* ProjectileClass, TArrayView<const FTransform> Transforms, AActor* Owner, float SubFrameAge = 0.f);
+
+	//Called by a pooled bullet when it hits something (bHit) or runs out of lifetime
+	void ReleaseProjectile(ABulletProjectile* Projectile, bool bHit);
+
+	//Number of dormant bullets spawned per class when a weapon is first seen
+	UPROPERTY(Config)
+	int32 PrewarmCount = 32;
+
+	//Maximum number of bullets a single class pool may own, shots over this are spawned unpooled
+	UPROPERTY(Config)
+	int32 HighWaterMark = 256;
+
+	//Shots served from a dormant bullet
+	int32 PoolHits = 0;
+	//Shots that had to spawn a new pooled bullet
+	int32 PoolMisses = 0;
+	//Shots that went over the high-water mark
+	int32 PoolOverflows = 0;
+	//Bullets returned after hitting something / after running out of lifetime
+	int32 ImpactReturns = 0;
+	int32 ExpiredReturns = 0;
+
+private:
+	ABulletProjectile* SpawnPooledProjectile(UClass* ProjectileClass, FProjectilePool& Pool);
+
+	UPROPERTY()
+	TMap<UClass*, FProjectilePool> Pools;
+};
@@ -0,0 +1,308 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ProjectileSimulationSubsystem.h"
+#include "GameJam2.h"
+#include "BulletProjectile.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "GameFramework/ProjectileMovementComponent.h"
+#include "GameFramework/Controller.h"
+#include "GameFramework/Pawn.h"
+#include "Kismet/GameplayStatics.h"
+#include "Engine/World.h"
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Bullet Simulation"), STAT_BulletSimulation, STATGROUP_GameJam2);
+DECLARE_CYCLE_STAT(TEXT("Bullet Integrate"), STAT_BulletIntegrate, STATGROUP_GameJam2);
+DECLARE_CYCLE_STAT(TEXT("Bullet Sweep"), STAT_BulletSweep, STATGROUP_GameJam2);
+DECLARE_CYCLE_STAT(TEXT("Bullet Resolve"), STAT_BulletResolve, STATGROUP_GameJam2);
+DECLARE_CYCLE_STAT(TEXT("Bullet Visuals"), STAT_BulletVisuals, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Simulated Bullets"), STAT_SimulatedBullets, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Simulated Bullet Hits"), STAT_SimulatedBulletHits, STATGROUP_GameJam2);
+
+//Spawns a ring of simulated bullets around the player, for measuring the simulation headless (-nullrhi)
+static FAutoConsoleCommandWithWorldAndArgs GBulletStressCommand(
+	TEXT("GameJam2.BulletStress"),
+	TEXT("GameJam2.BulletStress <Count> : spawn Count simulated bullets around the player"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		UProjectileSimulationSubsystem* Simulation = World ? World->GetSubsystem<UProjectileSimulationSubsystem>() : nullptr;
+		APawn* Player = UGameplayStatics::GetPlayerPawn(World, 0);
+		if (!Simulation || !Player)
+		{
+			return;
+		}
+
+		const int32 Count = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 10000;
+		const FVector Origin = Player->GetActorLocation();
+		for (int32 i = 0; i < Count; i++)
+		{
+			const FVector Direction = FRotator(0.f, 360.f * i / Count, 0.f).Vector();
+			Simulation->SpawnBullet(Origin + Direction * 100.f, Direction * 1500.f, 0.f, 5.f, Player);
+		}
+	}));
+
+void UProjectileSimulationSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	//Loaded while the world is being set up rather than on the first frame with a bullet
+	LoadedBulletMesh = BulletMesh.LoadSynchronous();
+	if (!LoadedBulletMesh && !BulletMesh.IsNull())
+	{
+		UE_LOG(LogGameJam2, Warning, TEXT("Projectile simulation: couldn't load bullet mesh %s"), *BulletMesh.ToString());
+	}
+}
+
+void UProjectileSimulationSubsystem::Deinitialize()
+{
+	if (VisualsActor)
+	{
+		VisualsActor->Destroy();
+		VisualsActor = nullptr;
+		VisualsComponent = nullptr;
+	}
+	Super::Deinitialize();
+}
+
+bool UProjectileSimulationSubsystem::IsTickable() const
+{
+	return GetNumBullets() > 0;
+}
+
+ETickableTickType UProjectileSimulationSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId UProjectileSimulationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UProjectileSimulationSubsystem, STATGROUP_Tickables);
+}
+
+void UProjectileSimulationSubsystem::GetBulletStats(UClass* ProjectileClass, float& OutSpeed, float& OutDamage, float& OutLifeTime)
+{
+	//Take the bullet's stats from its class defaults so designers keep tuning the blueprint
+	OutSpeed = 3000.f;
+	OutDamage = 10.f;
+	OutLifeTime = 3.f;
+	if (ProjectileClass && ProjectileClass->IsChildOf(ABulletProjectile::StaticClass()))
+	{
+		const ABulletProjectile* Defaults = ProjectileClass->GetDefaultObject<ABulletProjectile>();
+		OutSpeed = Defaults->ProjectileMovement->InitialSpeed;
+		OutDamage = Defaults->Damage;
+		OutLifeTime = Defaults->MaxLifeTime;
+	}
+}
+
+void UProjectileSimulationSubsystem::SpawnBullet(UClass* ProjectileClass, const FVector& Location, const FRotator& Rotation, AActor* Owner)
+{
+	float Speed, Damage, LifeTime;
+	GetBulletStats(ProjectileClass, Speed, Damage, LifeTime);
+	SpawnBullet(Location, Rotation.Vector() * Speed, Damage, LifeTime, Owner);
+}
+
+void UProjectileSimulationSubsystem::SpawnBullets(UClass* ProjectileClass, TArrayView<const FTransform> Transforms, AActor* Owner, float SubFrameAge)
+{
+	float Speed, Damage, LifeTime;
+	GetBulletStats(ProjectileClass, Speed, Damage, LifeTime);
+	for (const FTransform& Transform : Transforms)
+	{
+		const FVector Velocity = Transform.GetRotation().GetForwardVector() * Speed;
+		SpawnBullet(Transform.GetLocation() + Velocity * SubFrameAge, Velocity, Damage, LifeTime - SubFrameAge, Owner);
+	}
+}
+
+void UProjectileSimulationSubsystem::SpawnBullet(const FVector& Location, const FVector& Velocity, float Damage, float LifeTime, AActor* Owner)
+{
+	if (GetNumBullets() >= MaxBullets)
+	{
+		return;
+	}
+
+	PosX.Add(Location.X);
+	PosY.Add(Location.Y);
+	PosZ.Add(Location.Z);
+	PrevX.Add(Location.X);
+	PrevY.Add(Location.Y);
+	PrevZ.Add(Location.Z);
+	VelX.Add(Velocity.X);
+	VelY.Add(Velocity.Y);
+	VelZ.Add(Velocity.Z);
+	LifeTimes.Add(LifeTime);
+	Damages.Add(Damage);
+	Owners.Add(Owner);
+}
+
+void UProjectileSimulationSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_BulletSimulation);
+
+	IntegrateBullets(DeltaTime);
+	SweepBullets();
+	ResolveBullets();
+	UpdateVisuals();
+
+	SET_DWORD_STAT(STAT_SimulatedBullets, GetNumBullets());
+}
+
+void UProjectileSimulationSubsystem::IntegrateBullets(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_BulletIntegrate);
+
+	const int32 Num = GetNumBullets();
+
+	//Keep last frame's positions as the sweep start
+	FMemory::Memcpy(PrevX.GetData(), PosX.GetData(), Num * sizeof(float));
+	FMemory::Memcpy(PrevY.GetData(), PosY.GetData(), Num * sizeof(float));
+	FMemory::Memcpy(PrevZ.GetData(), PosZ.GetData(), Num * sizeof(float));
+
+	float* RESTRICT X = PosX.GetData();
+	float* RESTRICT Y = PosY.GetData();
+	float* RESTRICT Z = PosZ.GetData();
+	const float* RESTRICT VX = VelX.GetData();
+	const float* RESTRICT VY = VelY.GetData();
+	const float* RESTRICT VZ = VelZ.GetData();
+	float* RESTRICT Life = LifeTimes.GetData();
+
+	const VectorRegister Delta = VectorSetFloat1(DeltaTime);
+	const int32 NumVectorized = Num & ~3;
+	for (int32 i = 0; i < NumVectorized; i += 4)
+	{
+		VectorStore(VectorMultiplyAdd(VectorLoad(VX + i), Delta, VectorLoad(X + i)), X + i);
+		VectorStore(VectorMultiplyAdd(VectorLoad(VY + i), Delta, VectorLoad(Y + i)), Y + i);
+		VectorStore(VectorMultiplyAdd(VectorLoad(VZ + i), Delta, VectorLoad(Z + i)), Z + i);
+		VectorStore(VectorSubtract(VectorLoad(Life + i), Delta), Life + i);
+	}
+	for (int32 i = NumVectorized; i < Num; i++)
+	{
+		X[i] += VX[i] * DeltaTime;
+		Y[i] += VY[i] * DeltaTime;
+		Z[i] += VZ[i] * DeltaTime;
+		Life[i] -= DeltaTime;
+	}
+}
+
+void UProjectileSimulationSubsystem::SweepBullets()
+{
+	SCOPE_CYCLE_COUNTER(STAT_BulletSweep);
+
+	const int32 Num = GetNumBullets();
+	UWorld* World = GetWorld();
+
+	//Resolve weak pointers here, the workers only see raw pointers
+	SweepIgnore.SetNumUninitialized(Num, false);
+	for (int32 i = 0; i < Num; i++)
+	{
+		SweepIgnore[i] = Owners[i].Get();
+	}
+	SweepHit.SetNumZeroed(Num, false);
+	SweepResults.SetNum(Num, false);
+
+	const FCollisionObjectQueryParams ObjectParams(ECC_TO_BITFIELD(ECC_WorldStatic) | ECC_TO_BITFIELD(ECC_WorldDynamic) | ECC_TO_BITFIELD(ECC_Pawn));
+	const int32 BatchSize = FMath::Max(SweepBatchSize, 1);
+	const int32 NumBatches = FMath::DivideAndRoundUp(Num, BatchSize);
+
+	ParallelFor(NumBatches, [&](int32 Batch)
+	{
+		const int32 Start = Batch * BatchSize;
+		const int32 End = FMath::Min(Start + BatchSize, Num);
+		for (int32 i = Start; i < End; i++)
+		{
+			FCollisionQueryParams Params(SCENE_QUERY_STAT(BulletSweep), false, SweepIgnore[i]);
+			SweepHit[i] = World->LineTraceSingleByObjectType(SweepResults[i], FVector(PrevX[i], PrevY[i], PrevZ[i]), FVector(PosX[i], PosY[i], PosZ[i]), ObjectParams, Params) ? 1 : 0;
+		}
+	});
+}
+
+void UProjectileSimulationSubsystem::ResolveBullets()
+{
+	SCOPE_CYCLE_COUNTER(STAT_BulletResolve);
+
+	//Backwards so RemoveAtSwap only moves bullets we've already visited
+	for (int32 i = GetNumBullets() - 1; i >= 0; i--)
+	{
+		if (SweepHit[i])
+		{
+			INC_DWORD_STAT(STAT_SimulatedBulletHits);
+			const FHitResult& Hit = SweepResults[i];
+			AActor* HitActor = Hit.GetActor();
+			if (HitActor && Damages[i] > 0.f)
+			{
+				AActor* Owner = SweepIgnore[i];
+				APawn* OwnerPawn = Cast<APawn>(Owner);
+				UGameplayStatics::ApplyPointDamage(HitActor, Damages[i], FVector(VelX[i], VelY[i], VelZ[i]).GetSafeNormal(), Hit, OwnerPawn ? OwnerPawn->GetController() : nullptr, Owner, nullptr);
+			}
+			RemoveBullet(i);
+		}
+		else if (LifeTimes[i] <= 0.f)
+		{
+			RemoveBullet(i);
+		}
+	}
+}
+
+void UProjectileSimulationSubsystem::RemoveBullet(int32 Index)
+{
+	PosX.RemoveAtSwap(Index, 1, false);
+	PosY.RemoveAtSwap(Index, 1, false);
+	PosZ.RemoveAtSwap(Index, 1, false);
+	PrevX.RemoveAtSwap(Index, 1, false);
+	PrevY.RemoveAtSwap(Index, 1, false);
+	PrevZ.RemoveAtSwap(Index, 1, false);
+	VelX.RemoveAtSwap(Index, 1, false);
+	VelY.RemoveAtSwap(Index, 1, false);
+	VelZ.RemoveAtSwap(Index, 1, false);
+	LifeTimes.RemoveAtSwap(Index, 1, false);
+	Damages.RemoveAtSwap(Index, 1, false);
+	Owners.RemoveAtSwap(Index, 1, false);
+}
+
+void UProjectileSimulationSubsystem::UpdateVisuals()
+{
+	SCOPE_CYCLE_COUNTER(STAT_BulletVisuals);
+
+	UWorld* World = GetWorld();
+	if (!VisualsComponent)
+	{
+		if (!LoadedBulletMesh)
+		{
+			return;
+		}
+
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.ObjectFlags |= RF_Transient;
+		VisualsActor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParams);
+		VisualsComponent = NewObject<UInstancedStaticMeshComponent>(VisualsActor, TEXT("BulletInstances"));
+		VisualsComponent->SetStaticMesh(LoadedBulletMesh);
+		VisualsComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		VisualsComponent->SetCastShadow(false);
+		VisualsComponent->SetMobility(EComponentMobility::Movable);
+		VisualsActor->SetRootComponent(VisualsComponent);
+		VisualsComponent->RegisterComponent();
+	}
+
+	const int32 Num = GetNumBullets();
+	InstanceTransforms.SetNum(Num, false);
+	for (int32 i = 0; i < Num; i++)
+	{
+		const FVector Velocity(VelX[i], VelY[i], VelZ[i]);
+		InstanceTransforms[i] = FTransform(Velocity.ToOrientationQuat(), FVector(PosX[i], PosY[i], PosZ[i]));
+	}
+
+	//Only add or remove instances at the end, everything else is one batched update
+	while (VisualsComponent->GetInstanceCount() > Num)
+	{
+		VisualsComponent->RemoveInstance(VisualsComponent->GetInstanceCount() - 1);
+	}
+	while (VisualsComponent->GetInstanceCount() < Num)
+	{
+		VisualsComponent->AddInstance(FTransform::Identity);
+	}
+	if (Num > 0)
+	{
+		VisualsComponent->BatchUpdateInstancesTransforms(0, InstanceTransforms, true, true, true);
+	}
+}
@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ProjectileSimulationSubsystem.generated.h"
+
+class UInstancedStaticMeshComponent;
+class UStaticMesh;
+
+/**
+ * Simulates bullets as plain data instead of one actor each.
+ * Every live bullet is a row in a set of parallel arrays, moved in one SIMD pass per frame,
+ * swept against the world in parallel and drawn through a single instanced mesh.
+ */
+UCLASS(config = Game)
+class GAMEJAM2_API UProjectileSimulationSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End FTickableGameObject interface
+
+	//Add a bullet using the speed, damage and lifetime of a bullet class
+	void SpawnBullet(UClass* ProjectileClass, const FVector& Location, const FRotator& Rotation, AActor* Owner);
+
+	//Add one bullet per transform, looking the class stats up once.
+	//SubFrameAge moves the bullets on by the time they were fired before the end of the frame
+	void SpawnBullets(UClass* ProjectileClass, TArrayView<const FTransform> Transforms, AActor* Owner, float SubFrameAge = 0.f);
+
+	//Add a bullet with explicit values
+	void SpawnBullet(const FVector& Location, const FVector& Velocity, float Damage, float LifeTime, AActor* Owner);
+
+	int32 GetNumBullets() const { return PosX.Num(); }
+
+	//Mesh used to draw every simulated bullet
+	UPROPERTY(Config)
+	TSoftObjectPtr<UStaticMesh> BulletMesh;
+
+	//Hard cap on live bullets, new bullets are dropped past this
+	UPROPERTY(Config)
+	int32 MaxBullets = 16384;
+
+	//Bullets per ParallelFor batch when sweeping
+	UPROPERTY(Config)
+	int32 SweepBatchSize = 64;
+
+	//Speed, damage and lifetime from a bullet class' defaults
+	static void GetBulletStats(UClass* ProjectileClass, float& OutSpeed, float& OutDamage, float& OutLifeTime);
+
+private:
+	//Move every bullet by its velocity and age it (SIMD, 4 bullets per step)
+	void IntegrateBullets(float DeltaTime);
+
+	//Trace each bullet from its previous to its new position
+	void SweepBullets();
+
+	//Apply damage for hits and remove dead bullets
+	void ResolveBullets();
+
+	void UpdateVisuals();
+
+	void RemoveBullet(int32 Index);
+
+	// Structure of arrays, index i in each is the same bullet
+	TArray<float> PosX;
+	TArray<float> PosY;
+	TArray<float> PosZ;
+	TArray<float> PrevX;
+	TArray<float> PrevY;
+	TArray<float> PrevZ;
+	TArray<float> VelX;
+	TArray<float> VelY;
+	TArray<float> VelZ;
+	TArray<float> LifeTimes;
+	TArray<float> Damages;
+	TArray<TWeakObjectPtr<AActor>> Owners;
+
+	//Per frame scratch, filled by the sweep
+	TArray<AActor*> SweepIgnore;
+	TArray<uint8> SweepHit;
+	TArray<FHitResult> SweepResults;
+	TArray<FTransform> InstanceTransforms;
+
+	//BulletMesh, loaded once with the world. Null if it failed, bullets are then simulated but not drawn
+	UPROPERTY()
+	UStaticMesh* LoadedBulletMesh;
+
+	UPROPERTY()
+	AActor* VisualsActor;
+
+	UPROPERTY()
+	UInstancedStaticMeshComponent* VisualsComponent;
+};
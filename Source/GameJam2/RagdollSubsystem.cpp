@@ -0,0 +1,213 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "RagdollSubsystem.h"
+#include "GameJam2.h"
+#include "AICharacter.h"
+#include "EnemyPoolSubsystem.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Ragdolls"), STAT_Ragdolls, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ragdolls Simulating"), STAT_RagdollsSimulating, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ragdoll Bodies Simulating"), STAT_RagdollBodies, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Corpses"), STAT_Corpses, STATGROUP_GameJam2);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Corpses Evicted"), STAT_CorpsesEvicted, STATGROUP_GameJam2);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Physics Step (ms)"), STAT_RagdollPhysicsMs, STATGROUP_GameJam2);
+
+void FRagdollPhysicsTimer::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Owner)
+	{
+		Owner->OnPhysicsTimer(bEnd);
+	}
+}
+
+void URagdollSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	//Time the physics step so ragdoll cost can be read next to the body counts
+	UWorld* World = GetWorld();
+	if (World && World->IsGameWorld() && World->PersistentLevel)
+	{
+		PhysicsStartTimer.Owner = this;
+		PhysicsStartTimer.TickGroup = TG_StartPhysics;
+		PhysicsStartTimer.AddPrerequisite(World, World->StartPhysicsTickFunction);
+		PhysicsStartTimer.RegisterTickFunction(World->PersistentLevel);
+
+		PhysicsEndTimer.Owner = this;
+		PhysicsEndTimer.bEnd = true;
+		PhysicsEndTimer.TickGroup = TG_EndPhysics;
+		PhysicsEndTimer.AddPrerequisite(World, World->EndPhysicsTickFunction);
+		PhysicsEndTimer.RegisterTickFunction(World->PersistentLevel);
+	}
+}
+
+void URagdollSubsystem::Deinitialize()
+{
+	PhysicsStartTimer.UnRegisterTickFunction();
+	PhysicsEndTimer.UnRegisterTickFunction();
+	Super::Deinitialize();
+}
+
+void URagdollSubsystem::OnPhysicsTimer(bool bEnd)
+{
+	if (bEnd)
+	{
+		SET_FLOAT_STAT(STAT_RagdollPhysicsMs, (FPlatformTime::Seconds() - PhysicsStartTime) * 1000.0);
+	}
+	else
+	{
+		PhysicsStartTime = FPlatformTime::Seconds();
+	}
+}
+
+bool URagdollSubsystem::IsTickable() const
+{
+	return Corpses.Num() > 0;
+}
+
+ETickableTickType URagdollSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId URagdollSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(URagdollSubsystem, STATGROUP_Tickables);
+}
+
+void URagdollSubsystem::AddCorpse(AAICharacter* Corpse)
+{
+	if (!Corpse)
+	{
+		return;
+	}
+
+	//Make room first so the cap holds on the frame of a big multi-kill too
+	EnforceSimulationCap(MaxSimulatingRagdolls - 1);
+	while (Corpses.Num() >= MaxCorpses && Corpses.Num() > 0)
+	{
+		RemoveCorpse(0);
+	}
+
+	FRagdollCorpse& Entry = Corpses.AddDefaulted_GetRef();
+	Entry.Corpse = Corpse;
+	Entry.DeathTime = GetWorld()->GetTimeSeconds();
+	if (MaxSimulatingRagdolls > 0)
+	{
+		StartRagdoll(Corpse);
+		Entry.bSimulating = true;
+	}
+	else
+	{
+		FreezeRagdoll(Corpse);
+	}
+}
+
+void URagdollSubsystem::StartRagdoll(AAICharacter* Corpse)
+{
+	USkeletalMeshComponent* Mesh = Corpse->GetMesh();
+	Mesh->SetComponentTickEnabled(true);
+	Mesh->SetCollisionProfileName(TEXT("Ragdoll"));
+	Mesh->SetAllBodiesSimulatePhysics(true);
+	Mesh->SetSimulatePhysics(true);
+	Mesh->WakeAllRigidBodies();
+	Mesh->bBlendPhysics = true;
+}
+
+void URagdollSubsystem::FreezeRagdoll(AAICharacter* Corpse)
+{
+	//Keep the bones where physics left them and take the bodies out of the simulation
+	USkeletalMeshComponent* Mesh = Corpse->GetMesh();
+	Mesh->SetSimulatePhysics(false);
+	Mesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Mesh->bNoSkeletonUpdate = true;
+	Mesh->SetComponentTickEnabled(false);
+}
+
+void URagdollSubsystem::EnforceSimulationCap(int32 MaxSimulating)
+{
+	int32 Simulating = 0;
+	for (const FRagdollCorpse& Entry : Corpses)
+	{
+		Simulating += Entry.bSimulating ? 1 : 0;
+	}
+
+	//Oldest ragdolls have had the most time to settle, freeze them first
+	for (int32 i = 0; i < Corpses.Num() && Simulating > FMath::Max(MaxSimulating, 0); i++)
+	{
+		FRagdollCorpse& Entry = Corpses[i];
+		if (Entry.bSimulating && Entry.Corpse.IsValid())
+		{
+			FreezeRagdoll(Entry.Corpse.Get());
+			Entry.bSimulating = false;
+			Simulating--;
+		}
+	}
+}
+
+void URagdollSubsystem::RemoveCorpse(int32 Index)
+{
+	if (AAICharacter* Corpse = Corpses[Index].Corpse.Get())
+	{
+		//Pooled enemies go back to sleep to be handed out again
+		if (UEnemyPoolSubsystem* Pool = Corpse->OwningPool.Get())
+		{
+			Pool->ReleaseEnemy(Corpse);
+		}
+		else
+		{
+			Corpse->Destroy();
+		}
+	}
+	Corpses.RemoveAt(Index, 1, false);
+	INC_DWORD_STAT(STAT_CorpsesEvicted);
+}
+
+void URagdollSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_Ragdolls);
+
+	const float Now = GetWorld()->GetTimeSeconds();
+	int32 Simulating = 0;
+	int32 Bodies = 0;
+	for (int32 i = Corpses.Num() - 1; i >= 0; i--)
+	{
+		FRagdollCorpse& Entry = Corpses[i];
+		AAICharacter* Corpse = Entry.Corpse.Get();
+		if (!Corpse)
+		{
+			Corpses.RemoveAt(i, 1, false);
+			continue;
+		}
+
+		const float Age = Now - Entry.DeathTime;
+		if (CorpseLifeTime > 0.f && Age > CorpseLifeTime)
+		{
+			RemoveCorpse(i);
+			continue;
+		}
+
+		if (Entry.bSimulating)
+		{
+			USkeletalMeshComponent* Mesh = Corpse->GetMesh();
+			const bool bSettled = Age > MinSimulateTime && Mesh->GetPhysicsLinearVelocity().Size() < SettledSpeed;
+			if (bSettled || Age > MaxSimulateTime)
+			{
+				FreezeRagdoll(Corpse);
+				Entry.bSimulating = false;
+			}
+			else
+			{
+				Simulating++;
+				Bodies += Mesh->Bodies.Num();
+			}
+		}
+	}
+
+	SET_DWORD_STAT(STAT_RagdollsSimulating, Simulating);
+	SET_DWORD_STAT(STAT_RagdollBodies, Bodies);
+	SET_DWORD_STAT(STAT_Corpses, Corpses.Num());
+}
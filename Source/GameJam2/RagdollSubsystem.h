@@ -0,0 +1,99 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "RagdollSubsystem.generated.h"
+
+class AAICharacter;
+class URagdollSubsystem;
+
+//A dead enemy's body
+struct FRagdollCorpse
+{
+	TWeakObjectPtr<AAICharacter> Corpse;
+	float DeathTime = 0.f;
+	bool bSimulating = false;
+};
+
+//Stamps the frame's physics step from just after it starts to just after it ends
+struct FRagdollPhysicsTimer : public FTickFunction
+{
+	URagdollSubsystem* Owner = nullptr;
+	bool bEnd = false;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override { return TEXT("FRagdollPhysicsTimer"); }
+};
+
+/**
+ * Turns dead enemies into ragdolls with a cap on how many simulate at once.
+ * Ragdolls freeze into a static pose once they settle (or after MaxSimulateTime), the oldest simulating
+ * ragdolls are frozen early when over the cap, and the oldest corpses are removed past MaxCorpses.
+ */
+UCLASS(config = Game)
+class GAMEJAM2_API URagdollSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End FTickableGameObject interface
+
+	//Start ragdolling a dead enemy
+	void AddCorpse(AAICharacter* Corpse);
+
+	//Most ragdolls simulating at once
+	UPROPERTY(Config)
+	int32 MaxSimulatingRagdolls = 8;
+
+	//Most corpses in the level, frozen or not
+	UPROPERTY(Config)
+	int32 MaxCorpses = 32;
+
+	//Ragdolls simulate at least this long before they can freeze
+	UPROPERTY(Config)
+	float MinSimulateTime = 0.5f;
+
+	//Ragdolls freeze after this long even if they haven't settled
+	UPROPERTY(Config)
+	float MaxSimulateTime = 4.f;
+
+	//Below this speed a ragdoll counts as settled
+	UPROPERTY(Config)
+	float SettledSpeed = 15.f;
+
+	//Corpses are removed after this long, 0 keeps them until evicted
+	UPROPERTY(Config)
+	float CorpseLifeTime = 60.f;
+
+	//Set by the physics timer
+	void OnPhysicsTimer(bool bEnd);
+
+private:
+	void StartRagdoll(AAICharacter* Corpse);
+
+	void FreezeRagdoll(AAICharacter* Corpse);
+
+	void EnforceSimulationCap(int32 MaxSimulating);
+
+	void RemoveCorpse(int32 Index);
+
+	//Oldest first
+	TArray<FRagdollCorpse> Corpses;
+
+	FRagdollPhysicsTimer PhysicsStartTimer;
+	FRagdollPhysicsTimer PhysicsEndTimer;
+	double PhysicsStartTime = 0.0;
+};
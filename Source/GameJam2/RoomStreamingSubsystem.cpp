@@ -0,0 +1,283 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "RoomStreamingSubsystem.h"
+#include "GameJam2.h"
+#include "EnemySpawner.h"
+#include "AISignificanceSubsystem.h"
+#include "FlowFieldSubsystem.h"
+#include "TacticalGridSubsystem.h"
+#include "Engine/LevelStreaming.h"
+#include "Engine/LevelStreamingDynamic.h"
+#include "Engine/LevelBounds.h"
+#include "Kismet/GameplayStatics.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Room Streaming"), STAT_RoomStreaming, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Streamed Rooms Loaded"), STAT_RoomsLoaded, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Streamed Rooms Pending"), STAT_RoomsPending, STATGROUP_GameJam2);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Room Load Latency (s)"), STAT_RoomLoadLatency, STATGROUP_GameJam2);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Room Streaming Hitches"), STAT_RoomStreamingHitches, STATGROUP_GameJam2);
+
+static FAutoConsoleCommandWithWorld GRoomStreamingStatsCommand(
+	TEXT("GameJam2.RoomStreamingStats"),
+	TEXT("Log loaded rooms, load latency and hitches while streaming"),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		if (URoomStreamingSubsystem* Streaming = World ? World->GetSubsystem<URoomStreamingSubsystem>() : nullptr)
+		{
+			UE_LOG(LogGameJam2, Display, TEXT("Room streaming: %d loaded, %d pending, %d streamed actors, %d loads, %d unloads"),
+				Streaming->GetNumLoadedRooms(), Streaming->GetNumPendingRooms(), Streaming->GetNumStreamedActors(), Streaming->Loads, Streaming->Unloads);
+			UE_LOG(LogGameJam2, Display, TEXT("Room load latency: %.3f s last, %.3f s average, %.3f s max. %d hitches, worst %.1f ms"),
+				Streaming->LastLoadLatency, Streaming->Loads > 0 ? Streaming->TotalLoadLatency / Streaming->Loads : 0.f, Streaming->MaxLoadLatency,
+				Streaming->Hitches, Streaming->WorstHitchMs);
+		}
+	}));
+
+bool URoomStreamingSubsystem::IsTickable() const
+{
+	return Rooms.Num() > 0;
+}
+
+ETickableTickType URoomStreamingSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId URoomStreamingSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(URoomStreamingSubsystem, STATGROUP_Tickables);
+}
+
+void URoomStreamingSubsystem::RegisterRoom(AEnemySpawner* Spawner, const TSoftObjectPtr<UWorld>& Level)
+{
+	if (!Spawner || Level.IsNull())
+	{
+		return;
+	}
+	FStreamedRoom& Room = Rooms.AddDefaulted_GetRef();
+	Room.Spawner = Spawner;
+	Room.Level = Level;
+	Room.Streaming = FindStreaming(Room);
+
+	//Sublevels placed in the persistent level may be set to load with it, go by their current state
+	if (ULevelStreaming* Streaming = Room.Streaming.Get())
+	{
+		Room.bWantLoaded = Streaming->ShouldBeLoaded();
+	}
+}
+
+void URoomStreamingSubsystem::UnregisterRoom(AEnemySpawner* Spawner)
+{
+	Rooms.RemoveAllSwap([Spawner](const FStreamedRoom& Room) { return Room.Spawner == Spawner; });
+}
+
+int32 URoomStreamingSubsystem::GetNumLoadedRooms() const
+{
+	int32 Loaded = 0;
+	for (const FStreamedRoom& Room : Rooms)
+	{
+		Loaded += Room.bWantLoaded && !Room.bPending ? 1 : 0;
+	}
+	return Loaded;
+}
+
+int32 URoomStreamingSubsystem::GetNumPendingRooms() const
+{
+	int32 Pending = 0;
+	for (const FStreamedRoom& Room : Rooms)
+	{
+		Pending += Room.bPending ? 1 : 0;
+	}
+	return Pending;
+}
+
+int32 URoomStreamingSubsystem::GetNumStreamedActors() const
+{
+	int32 Actors = 0;
+	for (const FStreamedRoom& Room : Rooms)
+	{
+		const ULevelStreaming* Streaming = Room.Streaming.Get();
+		if (const ULevel* Level = Streaming ? Streaming->GetLoadedLevel() : nullptr)
+		{
+			Actors += Level->Actors.Num();
+		}
+	}
+	return Actors;
+}
+
+void URoomStreamingSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_RoomStreaming);
+
+	//Only frames spent streaming count, other hitches aren't ours
+	const int32 Pending = GetNumPendingRooms();
+	const float FrameMs = DeltaTime * 1000.f;
+	if (Pending > 0 && FrameMs > HitchThresholdMs)
+	{
+		Hitches++;
+		WorstHitchMs = FMath::Max(WorstHitchMs, FrameMs);
+		INC_DWORD_STAT(STAT_RoomStreamingHitches);
+	}
+
+	const float Now = GetWorld()->GetTimeSeconds();
+	if (Now >= NextUpdateTime)
+	{
+		NextUpdateTime = Now + UpdateInterval;
+		UpdateWantedRooms();
+	}
+	PollPendingRooms();
+
+	SET_DWORD_STAT(STAT_RoomsLoaded, GetNumLoadedRooms());
+	SET_DWORD_STAT(STAT_RoomsPending, GetNumPendingRooms());
+	SET_FLOAT_STAT(STAT_RoomLoadLatency, LastLoadLatency);
+}
+
+void URoomStreamingSubsystem::UpdateWantedRooms()
+{
+	APawn* Player = UGameplayStatics::GetPlayerPawn(this, 0);
+	if (!Player)
+	{
+		return;
+	}
+
+	const FVector Location = Player->GetActorLocation();
+	const FVector Heading = Player->GetVelocity().GetSafeNormal2D();
+	const float CosPredictAngle = FMath::Cos(FMath::DegreesToRadians(PredictAngle));
+	const UAISignificanceSubsystem* Significance = GetWorld()->GetSubsystem<UAISignificanceSubsystem>();
+	const AEnemySpawner* PlayerRoom = Significance ? Significance->GetPlayerRoom() : nullptr;
+
+	for (FStreamedRoom& Room : Rooms)
+	{
+		const AEnemySpawner* Spawner = Room.Spawner.Get();
+		if (!Spawner)
+		{
+			continue;
+		}
+
+		//Distance to the room's walls once they are known, the spawner until then
+		const FVector ToRoom = Spawner->GetActorLocation() - Location;
+		const float Distance = Room.Bounds.IsValid ? FMath::Sqrt(Room.Bounds.ComputeSquaredDistanceToPoint(Location)) : ToRoom.Size2D();
+
+		//Rooms ahead of the player load from further away, so they are in before the player gets there
+		const bool bAhead = !Heading.IsZero() && FVector::DotProduct(Heading, ToRoom.GetSafeNormal2D()) >= CosPredictAngle;
+		bool bWant = Spawner == PlayerRoom || Distance <= (bAhead ? PredictDistance : LoadDistance);
+
+		//Loaded rooms stay until the player is well clear, so walking along a boundary doesn't thrash
+		bWant |= Room.bWantLoaded && Distance <= UnloadDistance;
+
+		if (bWant != Room.bWantLoaded)
+		{
+			SetRoomLoaded(Room, bWant);
+		}
+	}
+	bFirstUpdate = false;
+}
+
+ULevelStreaming* URoomStreamingSubsystem::FindStreaming(const FStreamedRoom& Room) const
+{
+	//Rooms already set up as sublevels of the persistent level
+	const FName PackageName(*Room.Level.GetLongPackageName());
+	for (ULevelStreaming* Streaming : GetWorld()->GetStreamingLevels())
+	{
+		if (Streaming && Streaming->GetWorldAssetPackageFName() == PackageName)
+		{
+			return Streaming;
+		}
+	}
+	return nullptr;
+}
+
+void URoomStreamingSubsystem::SetRoomLoaded(FStreamedRoom& Room, bool bLoad)
+{
+	ULevelStreaming* Streaming = Room.Streaming.Get();
+	if (!Streaming)
+	{
+		if (!bLoad)
+		{
+			return;
+		}
+
+		//Not a sublevel of the map, stream it in as an instance where it was authored
+		bool bSuccess = false;
+		Streaming = ULevelStreamingDynamic::LoadLevelInstanceBySoftObjectPtr(GetWorld(), Room.Level, FVector::ZeroVector, FRotator::ZeroRotator, bSuccess);
+		if (!bSuccess || !Streaming)
+		{
+			UE_LOG(LogGameJam2, Warning, TEXT("Room streaming: couldn't load %s"), *Room.Level.ToString());
+			return;
+		}
+		Room.Streaming = Streaming;
+	}
+
+	Streaming->bShouldBlockOnLoad = bLoad && bFirstUpdate;
+	Streaming->SetShouldBeLoaded(bLoad);
+	Streaming->SetShouldBeVisible(bLoad);
+	Room.bWantLoaded = bLoad;
+	Room.bPending = true;
+	Room.RequestTime = FPlatformTime::Seconds();
+}
+
+void URoomStreamingSubsystem::PollPendingRooms()
+{
+	for (FStreamedRoom& Room : Rooms)
+	{
+		if (!Room.bPending)
+		{
+			continue;
+		}
+		const ULevelStreaming* Streaming = Room.Streaming.Get();
+		if (!Streaming)
+		{
+			Room.bPending = false;
+			continue;
+		}
+
+		const bool bDone = Room.bWantLoaded ? Streaming->IsLevelVisible() : !Streaming->IsLevelLoaded();
+		if (!bDone)
+		{
+			continue;
+		}
+		Room.bPending = false;
+
+		if (Room.bWantLoaded)
+		{
+			LastLoadLatency = float(FPlatformTime::Seconds() - Room.RequestTime);
+			MaxLoadLatency = FMath::Max(MaxLoadLatency, LastLoadLatency);
+			TotalLoadLatency += LastLoadLatency;
+			Loads++;
+			if (ULevel* Level = Streaming->GetLoadedLevel())
+			{
+				Room.Bounds = ALevelBounds::CalculateLevelBounds(Level);
+			}
+
+			//The room's floor is in now, so its spawn slots can find the nav mesh
+			if (AEnemySpawner* Spawner = Room.Spawner.Get())
+			{
+				Spawner->BuildSpawnSlots();
+			}
+		}
+		else
+		{
+			Unloads++;
+		}
+		InvalidateRoom(Room);
+	}
+}
+
+void URoomStreamingSubsystem::InvalidateRoom(const FStreamedRoom& Room) const
+{
+	if (!Room.Bounds.IsValid)
+	{
+		return;
+	}
+	if (UFlowFieldSubsystem* FlowField = GetWorld()->GetSubsystem<UFlowFieldSubsystem>())
+	{
+		FlowField->InvalidateRegion(Room.Bounds);
+	}
+
+	//The tactical grid re-bakes the room's cells, and everyone's view into it, a few traces per frame
+	if (UTacticalGridSubsystem* TacticalGrid = GetWorld()->GetSubsystem<UTacticalGridSubsystem>())
+	{
+		TacticalGrid->InvalidateRegion(Room.Bounds);
+	}
+}
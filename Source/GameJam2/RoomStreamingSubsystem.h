@@ -0,0 +1,112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "RoomStreamingSubsystem.generated.h"
+
+class AEnemySpawner;
+class ULevelStreaming;
+
+//A spawner's room sublevel and where its streaming is at
+struct FStreamedRoom
+{
+	TWeakObjectPtr<AEnemySpawner> Spawner;
+	TSoftObjectPtr<UWorld> Level;
+	TWeakObjectPtr<ULevelStreaming> Streaming;
+
+	//Bounds of the loaded level, invalid until it has been loaded once
+	FBox Bounds = FBox(ForceInit);
+
+	//Real time the last load or unload was asked for
+	double RequestTime = 0.0;
+
+	bool bWantLoaded = false;
+	bool bPending = false;
+};
+
+/**
+ * Streams each room's walls, traps and lights in and out as the player moves, one sublevel per AEnemySpawner.
+ * Rooms near the player load, rooms further out ahead of the player's heading load early so they are in before
+ * the player gets there, and rooms left behind past UnloadDistance unload. The room the player is in never unloads.
+ * Spawners and their entrance triggers stay in the persistent level.
+ */
+UCLASS(config = Game)
+class GAMEJAM2_API URoomStreamingSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End FTickableGameObject interface
+
+	void RegisterRoom(AEnemySpawner* Spawner, const TSoftObjectPtr<UWorld>& Level);
+	void UnregisterRoom(AEnemySpawner* Spawner);
+
+	//Rooms closer than this always load
+	UPROPERTY(Config)
+	float LoadDistance = 3000.f;
+
+	//Rooms within PredictAngle of the player's heading load from this far
+	UPROPERTY(Config)
+	float PredictDistance = 6000.f;
+
+	//Half angle in degrees
+	UPROPERTY(Config)
+	float PredictAngle = 45.f;
+
+	//Loaded rooms further than this unload
+	UPROPERTY(Config)
+	float UnloadDistance = 8000.f;
+
+	//Seconds between deciding which rooms should be loaded
+	UPROPERTY(Config)
+	float UpdateInterval = 0.25f;
+
+	//Frames longer than this while streaming count as hitches
+	UPROPERTY(Config)
+	float HitchThresholdMs = 50.f;
+
+	//Latency from asking for a room to it being visible, in seconds
+	float LastLoadLatency = 0.f;
+	float MaxLoadLatency = 0.f;
+	float TotalLoadLatency = 0.f;
+	int32 Loads = 0;
+	int32 Unloads = 0;
+
+	//Frames over HitchThresholdMs while a room was streaming
+	int32 Hitches = 0;
+	float WorstHitchMs = 0.f;
+
+	int32 GetNumLoadedRooms() const;
+	int32 GetNumPendingRooms() const;
+
+	//Actors in the loaded room sublevels
+	int32 GetNumStreamedActors() const;
+
+private:
+	void UpdateWantedRooms();
+
+	void SetRoomLoaded(FStreamedRoom& Room, bool bLoad);
+
+	ULevelStreaming* FindStreaming(const FStreamedRoom& Room) const;
+
+	void PollPendingRooms();
+
+	//Flow field walkability and tactical grid cells over a room that just appeared or went away are stale
+	void InvalidateRoom(const FStreamedRoom& Room) const;
+
+	TArray<FStreamedRoom> Rooms;
+
+	float NextUpdateTime = 0.f;
+
+	//First update blocks on loading the rooms around the player, so the start room is never missing
+	bool bFirstUpdate = true;
+};
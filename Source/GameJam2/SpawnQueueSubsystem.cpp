@@ -0,0 +1,123 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SpawnQueueSubsystem.h"
+#include "GameJam2.h"
+#include "EnemyCrowdSubsystem.h"
+#include "Kismet/GameplayStatics.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Spawn Queue"), STAT_SpawnQueue, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Spawn Queue Depth"), STAT_SpawnQueueDepth, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Spawn Queue Spawns"), STAT_SpawnQueueSpawns, STATGROUP_GameJam2);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Spawn Queue Max Wait (s)"), STAT_SpawnQueueMaxWait, STATGROUP_GameJam2);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Spawn Queue Average Wait (s)"), STAT_SpawnQueueAverageWait, STATGROUP_GameJam2);
+
+static FAutoConsoleCommandWithWorld GSpawnQueueStatsCommand(
+	TEXT("GameJam2.SpawnQueueStats"),
+	TEXT("Log the spawn queue depth and how long the last frame's spawns waited"),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		if (USpawnQueueSubsystem* Queue = World ? World->GetSubsystem<USpawnQueueSubsystem>() : nullptr)
+		{
+			UE_LOG(LogGameJam2, Display, TEXT("Spawn queue: %d queued, %d spawned last frame, %.3f s max wait, %.3f s average wait, %.1f us per spawn"),
+				Queue->GetNumQueued(), Queue->LastSpawned, Queue->LastMaxWait, Queue->LastAverageWait, Queue->AverageSpawnMicroseconds);
+		}
+	}));
+
+bool USpawnQueueSubsystem::IsTickable() const
+{
+	return Requests.Num() > 0;
+}
+
+ETickableTickType USpawnQueueSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId USpawnQueueSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USpawnQueueSubsystem, STATGROUP_Tickables);
+}
+
+void USpawnQueueSubsystem::SubmitSpawn(UClass* EnemyClass, const FVector& Location, const FRotator& Rotation, AActor* Room, int32 Health, int32 Weapon)
+{
+	if (!EnemyClass)
+	{
+		return;
+	}
+	Requests.Add({ EnemyClass, Location, Rotation, Room, Health, Weapon, GetWorld()->GetTimeSeconds(), 0.f });
+	SET_DWORD_STAT(STAT_SpawnQueueDepth, Requests.Num());
+}
+
+void USpawnQueueSubsystem::CancelSpawns(AActor* Room)
+{
+	Requests.RemoveAll([Room](const FQueuedSpawn& Request) { return Request.Room == Room; });
+	SET_DWORD_STAT(STAT_SpawnQueueDepth, Requests.Num());
+}
+
+void USpawnQueueSubsystem::PrioritizeRequests(float Now)
+{
+	APawn* Player = UGameplayStatics::GetPlayerPawn(this, 0);
+	const FVector PlayerLocation = Player ? Player->GetActorLocation() : FVector::ZeroVector;
+	for (FQueuedSpawn& Request : Requests)
+	{
+		//Overdue requests go first, oldest first, then everything else nearest the player first
+		const float Wait = Now - Request.SubmitTime;
+		Request.Priority = Wait >= MaxWaitSeconds ? -Wait : (Player ? FVector::DistSquared(Request.Location, PlayerLocation) : Request.SubmitTime);
+	}
+
+	//Best request last so it can be popped off the end
+	Requests.Sort([](const FQueuedSpawn& A, const FQueuedSpawn& B) { return A.Priority > B.Priority; });
+}
+
+void USpawnQueueSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SpawnQueue);
+
+	UEnemyCrowdSubsystem* Crowd = GetWorld()->GetSubsystem<UEnemyCrowdSubsystem>();
+	if (!Crowd)
+	{
+		return;
+	}
+
+	const float Now = GetWorld()->GetTimeSeconds();
+	PrioritizeRequests(Now);
+
+	const double StartTime = FPlatformTime::Seconds();
+	float TotalWait = 0.f;
+	LastSpawned = 0;
+	LastMaxWait = 0.f;
+	while (Requests.Num() > 0)
+	{
+		//Stop once the next spawn would likely go over, but always make some progress
+		const float Elapsed = float(FPlatformTime::Seconds() - StartTime) * 1000000.f;
+		if (LastSpawned >= MinSpawnsPerFrame && Elapsed + AverageSpawnMicroseconds > BudgetMicroseconds)
+		{
+			break;
+		}
+
+		const FQueuedSpawn Request = Requests.Pop(false);
+		UClass* EnemyClass = Request.EnemyClass.Get();
+		if (!EnemyClass)
+		{
+			continue;
+		}
+
+		const double SpawnStart = FPlatformTime::Seconds();
+		Crowd->SpawnEnemy(EnemyClass, Request.Location, Request.Rotation, Request.Room.Get(), Request.Health, Request.Weapon);
+		const float SpawnMicroseconds = float(FPlatformTime::Seconds() - SpawnStart) * 1000000.f;
+		AverageSpawnMicroseconds = AverageSpawnMicroseconds > 0.f ? FMath::Lerp(AverageSpawnMicroseconds, SpawnMicroseconds, 0.2f) : SpawnMicroseconds;
+
+		const float Wait = Now - Request.SubmitTime;
+		LastMaxWait = FMath::Max(LastMaxWait, Wait);
+		TotalWait += Wait;
+		LastSpawned++;
+	}
+	LastAverageWait = LastSpawned > 0 ? TotalWait / LastSpawned : 0.f;
+
+	SET_DWORD_STAT(STAT_SpawnQueueDepth, Requests.Num());
+	SET_DWORD_STAT(STAT_SpawnQueueSpawns, LastSpawned);
+	SET_FLOAT_STAT(STAT_SpawnQueueMaxWait, LastMaxWait);
+	SET_FLOAT_STAT(STAT_SpawnQueueAverageWait, LastAverageWait);
+}
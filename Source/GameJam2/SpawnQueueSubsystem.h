@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SpawnQueueSubsystem.generated.h"
+
+//An enemy waiting for its turn to be spawned
+struct FQueuedSpawn
+{
+	TWeakObjectPtr<UClass> EnemyClass;
+	FVector Location;
+	FRotator Rotation;
+	TWeakObjectPtr<AActor> Room;
+	int32 Health;
+	int32 Weapon;
+
+	//World time the request was submitted
+	float SubmitTime;
+
+	//Lower goes first, worked out each frame from the distance to the player
+	float Priority;
+};
+
+/**
+ * One queue every spawner submits its enemies to. Requests are spawned nearest the player first, and only as many
+ * per frame as fit in BudgetMicroseconds, so a wave starting in several rooms at once costs a little over a few
+ * frames instead of one long hitch. Requests that waited longer than MaxWaitSeconds jump the queue.
+ */
+UCLASS(config = Game)
+class GAMEJAM2_API USpawnQueueSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End FTickableGameObject interface
+
+	//Queue an enemy to be spawned by the crowd. Health <= 0 and Weapon < 0 keep the class defaults
+	void SubmitSpawn(UClass* EnemyClass, const FVector& Location, const FRotator& Rotation, AActor* Room, int32 Health = 0, int32 Weapon = -1);
+
+	//Drop every request still waiting for the room
+	void CancelSpawns(AActor* Room);
+
+	int32 GetNumQueued() const { return Requests.Num(); }
+
+	//Time per frame spent spawning, at least MinSpawnsPerFrame are spawned even when one spawn goes over it
+	UPROPERTY(Config)
+	float BudgetMicroseconds = 1500.f;
+
+	UPROPERTY(Config)
+	int32 MinSpawnsPerFrame = 1;
+
+	//Requests older than this are spawned before nearer ones so far rooms still fill up
+	UPROPERTY(Config)
+	float MaxWaitSeconds = 2.f;
+
+	//Spawns done last frame, and the longest and average wait of them in seconds
+	int32 LastSpawned = 0;
+	float LastMaxWait = 0.f;
+	float LastAverageWait = 0.f;
+
+	//Running average cost of one spawn in microseconds, used to stop before a spawn would go over the budget
+	float AverageSpawnMicroseconds = 0.f;
+
+private:
+	void PrioritizeRequests(float Now);
+
+	TArray<FQueuedSpawn> Requests;
+};
@@ -0,0 +1,119 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SpawnSlotGrid.h"
+#include "GameJam2.h"
+#include "PawnPerceptionSubsystem.h"
+#include "NavigationSystem.h"
+#include "Engine/World.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Spawn Slot Claims"), STAT_SpawnSlotClaims, STATGROUP_GameJam2);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Spawn Slot Overcommits"), STAT_SpawnSlotOvercommits, STATGROUP_GameJam2);
+
+void FSpawnSlotGrid::Build(UWorld* World, const FVector& Center, const FRotator& Rotation, int32 Dimension, float Spacing)
+{
+	Points.Reset();
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(World);
+	const FQuat Facing(FRotator(0.f, Rotation.Yaw, 0.f));
+	const float HalfExtent = (Dimension - 1) * 0.5f;
+	for (int32 Y = 0; Y < Dimension; Y++)
+	{
+		for (int32 X = 0; X < Dimension; X++)
+		{
+			const FVector Offset((X - HalfExtent) * Spacing, (Y - HalfExtent) * Spacing, 0.f);
+			FVector Point = Center + Facing.RotateVector(Offset);
+			if (NavSys)
+			{
+				FNavLocation NavLocation;
+				if (!NavSys->ProjectPointToNavigation(Point, NavLocation, FVector(Spacing * 0.5f, Spacing * 0.5f, 200.f)))
+				{
+					continue;
+				}
+				//Keep the spawn point's height, the nav mesh sits below the capsule centre
+				Point = FVector(NavLocation.Location.X, NavLocation.Location.Y, Center.Z);
+			}
+			Points.Add(Point);
+		}
+	}
+
+	//Nearest the centre first, so a single enemy still spawns on the spawn point
+	Points.Sort([&Center](const FVector& A, const FVector& B) { return FVector::DistSquared2D(A, Center) < FVector::DistSquared2D(B, Center); });
+
+	ClaimTimes.Init(0.f, Points.Num());
+	ClaimedSlots.SetNumUninitialized(Points.Num());
+	ClaimedHead = 0;
+	NumClaimed = 0;
+	FreeSlots.Reset(Points.Num());
+	for (int32 i = Points.Num() - 1; i >= 0; i--)
+	{
+		FreeSlots.Add(i);
+	}
+}
+
+void FSpawnSlotGrid::PushClaimed(int32 Slot)
+{
+	ClaimedSlots[(ClaimedHead + NumClaimed) % ClaimedSlots.Num()] = Slot;
+	NumClaimed++;
+}
+
+int32 FSpawnSlotGrid::PopClaimed()
+{
+	const int32 Slot = ClaimedSlots[ClaimedHead];
+	ClaimedHead = (ClaimedHead + 1) % ClaimedSlots.Num();
+	NumClaimed--;
+	return Slot;
+}
+
+FVector FSpawnSlotGrid::ClaimSlot(UWorld* World, const FVector& Center)
+{
+	if (Points.Num() == 0)
+	{
+		return Center;
+	}
+	INC_DWORD_STAT(STAT_SpawnSlotClaims);
+
+	//Hand back old claims whose enemy has walked off, at most two checks per claim so this stays constant time
+	const float Now = World->GetTimeSeconds();
+	const UPawnPerceptionSubsystem* Perception = World->GetSubsystem<UPawnPerceptionSubsystem>();
+	for (int32 Checks = 0; Checks < 2 && NumClaimed > 0; Checks++)
+	{
+		const int32 Oldest = ClaimedSlots[ClaimedHead];
+		if (Now - ClaimTimes[Oldest] < HoldSeconds)
+		{
+			break;
+		}
+		PopClaimed();
+
+		Blockers.Reset();
+		if (Perception)
+		{
+			Perception->GetPawnsInRadius(Points[Oldest], ClearRadius, Blockers);
+		}
+		if (Blockers.Num() > 0)
+		{
+			//Still standing there, look again later
+			ClaimTimes[Oldest] = Now;
+			PushClaimed(Oldest);
+		}
+		else
+		{
+			FreeSlots.Add(Oldest);
+		}
+	}
+
+	int32 Slot;
+	if (FreeSlots.Num() > 0)
+	{
+		Slot = FreeSlots.Pop(false);
+	}
+	else
+	{
+		//More enemies than slots, double up on the slot that was taken longest ago
+		Slot = PopClaimed();
+		INC_DWORD_STAT(STAT_SpawnSlotOvercommits);
+	}
+
+	ClaimTimes[Slot] = Now;
+	PushClaimed(Slot);
+	return Points[Slot];
+}
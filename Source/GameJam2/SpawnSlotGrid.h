@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UWorld;
+class APawn;
+
+/**
+ * A small grid of nav mesh points around a spawn point, so enemies spawned one after another don't land inside each other.
+ * Slots are handed out from a free list, nearest the centre first. A claimed slot is held for HoldSeconds, then handed
+ * back once no pawn is standing on it. When every slot is held the oldest claim is reused.
+ */
+struct GAMEJAM2_API FSpawnSlotGrid
+{
+	//Project a Dimension x Dimension grid, Spacing apart and turned to Rotation, onto the nav mesh around Center
+	void Build(UWorld* World, const FVector& Center, const FRotator& Rotation, int32 Dimension, float Spacing);
+
+	//Pick a slot for the next enemy. Falls back to Center when the grid has no slots
+	FVector ClaimSlot(UWorld* World, const FVector& Center);
+
+	int32 GetNumSlots() const { return Points.Num(); }
+
+	//Seconds a claimed slot stays taken before it is checked for being clear
+	float HoldSeconds = 2.f;
+
+	//Pawns within this of a slot keep it taken
+	float ClearRadius = 60.f;
+
+private:
+	void PushClaimed(int32 Slot);
+	int32 PopClaimed();
+
+	TArray<FVector> Points;
+	TArray<float> ClaimTimes;
+
+	//Stack of free slots, the nearest to the centre on top
+	TArray<int32> FreeSlots;
+
+	//Ring of claimed slots, oldest claim at ClaimedHead
+	TArray<int32> ClaimedSlots;
+	int32 ClaimedHead = 0;
+	int32 NumClaimed = 0;
+
+	//Scratch for the clear check
+	TArray<APawn*> Blockers;
+};
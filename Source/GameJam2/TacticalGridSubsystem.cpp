@@ -0,0 +1,440 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TacticalGridSubsystem.h"
+#include "GameJam2.h"
+#include "NavigationSystem.h"
+#include "NavMesh/NavMeshBoundsVolume.h"
+#include "Async/MappedFileHandle.h"
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "EngineUtils.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Tactical Grid Rebake"), STAT_TacticalRebake, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Tactical Grid Rebake Traces"), STAT_TacticalRebakeTraces, STATGROUP_GameJam2);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Tactical Grid Dirty Cells"), STAT_TacticalDirtyCells, STATGROUP_GameJam2);
+
+static const uint32 TacticalGridMagic = 0x44524754; // "TGRD"
+static const uint32 TacticalGridVersion = 1;
+static const int32 TacticalGridRegions = 8;
+
+static_assert(sizeof(FTacticalGridHeader) == 48, "Tactical grid header layout is part of the file format");
+static_assert(sizeof(FTacticalCell) == 16, "Tactical grid cell layout is part of the file format");
+
+//Unit directions for the cover mask bits
+static const FVector CoverDirections[8] =
+{
+	FVector(1.f, 0.f, 0.f), FVector(0.70710678f, 0.70710678f, 0.f), FVector(0.f, 1.f, 0.f), FVector(-0.70710678f, 0.70710678f, 0.f),
+	FVector(-1.f, 0.f, 0.f), FVector(-0.70710678f, -0.70710678f, 0.f), FVector(0.f, -1.f, 0.f), FVector(0.70710678f, -0.70710678f, 0.f),
+};
+
+static FAutoConsoleCommandWithWorld GBakeTacticalGridCommand(
+	TEXT("GameJam2.BakeTacticalGrid"),
+	TEXT("Bake cover and visibility for the current map into Content/TacticalGrid"),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		if (UTacticalGridSubsystem* Grid = World ? World->GetSubsystem<UTacticalGridSubsystem>() : nullptr)
+		{
+			Grid->Bake();
+		}
+	}));
+
+void UTacticalGridSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	LoadGrid();
+}
+
+void UTacticalGridSubsystem::Deinitialize()
+{
+	ReleaseGrid();
+	Super::Deinitialize();
+}
+
+bool UTacticalGridSubsystem::IsTickable() const
+{
+	return DirtyCells.Num() > 0 || DirtyRegions != 0;
+}
+
+ETickableTickType UTacticalGridSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId UTacticalGridSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTacticalGridSubsystem, STATGROUP_Tickables);
+}
+
+FString UTacticalGridSubsystem::GetGridFilename() const
+{
+	//Kept outside the pak (DirectoriesToAlwaysStageAsNonUFS) so it can be memory mapped
+	return FPaths::ProjectContentDir() / TEXT("TacticalGrid") / UWorld::RemovePIEPrefix(GetWorld()->GetMapName()) + TEXT(".tgrid");
+}
+
+bool UTacticalGridSubsystem::LoadGrid()
+{
+	ReleaseGrid();
+
+	const FString Filename = GetGridFilename();
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	if (!PlatformFile.FileExists(*Filename))
+	{
+		return false;
+	}
+
+	const uint8* Data = nullptr;
+	int64 Size = 0;
+	TArray<uint8> Bytes;
+	MappedHandle = PlatformFile.OpenMapped(*Filename);
+	if (MappedHandle)
+	{
+		MappedRegion = MappedHandle->MapRegion(0, MappedHandle->GetFileSize());
+		if (MappedRegion)
+		{
+			Data = MappedRegion->GetMappedPtr();
+			Size = MappedRegion->GetMappedSize();
+		}
+	}
+	if (!Data)
+	{
+		//Platforms without mapping read it in instead
+		if (!FFileHelper::LoadFileToArray(Bytes, *Filename))
+		{
+			ReleaseGrid();
+			return false;
+		}
+		Data = Bytes.GetData();
+		Size = Bytes.Num();
+	}
+
+	if (Size < (int64)sizeof(FTacticalGridHeader))
+	{
+		ReleaseGrid();
+		return false;
+	}
+	FMemory::Memcpy(&Header, Data, sizeof(FTacticalGridHeader));
+	const int64 NumCells = int64(Header.Width) * Header.Height;
+	if (Header.Magic != TacticalGridMagic || Header.Version != TacticalGridVersion
+		|| Size != (int64)sizeof(FTacticalGridHeader) + NumCells * (int64)sizeof(FTacticalCell))
+	{
+		UE_LOG(LogGameJam2, Warning, TEXT("%s is not a tactical grid this build understands, rebake it"), *Filename);
+		ReleaseGrid();
+		return false;
+	}
+
+	if (MappedRegion)
+	{
+		Cells = reinterpret_cast<const FTacticalCell*>(Data + sizeof(FTacticalGridHeader));
+	}
+	else
+	{
+		OwnedCells.SetNumUninitialized(NumCells);
+		FMemory::Memcpy(OwnedCells.GetData(), Data + sizeof(FTacticalGridHeader), NumCells * sizeof(FTacticalCell));
+		Cells = OwnedCells.GetData();
+	}
+	return true;
+}
+
+void UTacticalGridSubsystem::ReleaseGrid()
+{
+	Cells = nullptr;
+	delete MappedRegion;
+	MappedRegion = nullptr;
+	delete MappedHandle;
+	MappedHandle = nullptr;
+}
+
+void UTacticalGridSubsystem::MakeWritable()
+{
+	if (MappedRegion)
+	{
+		const int32 NumCells = Header.Width * Header.Height;
+		OwnedCells.SetNumUninitialized(NumCells);
+		FMemory::Memcpy(OwnedCells.GetData(), Cells, NumCells * sizeof(FTacticalCell));
+		ReleaseGrid();
+		Cells = OwnedCells.GetData();
+	}
+}
+
+bool UTacticalGridSubsystem::WorldToCell(const FVector& Location, int32& OutX, int32& OutY) const
+{
+	OutX = FMath::FloorToInt((Location.X - Header.OriginX) / Header.CellSize);
+	OutY = FMath::FloorToInt((Location.Y - Header.OriginY) / Header.CellSize);
+	return OutX >= 0 && OutY >= 0 && OutX < Header.Width && OutY < Header.Height;
+}
+
+FVector UTacticalGridSubsystem::CellEye(int32 X, int32 Y) const
+{
+	const float Height = Cells ? Cells[Y * Header.Width + X].Height : 0.f;
+	return FVector(Header.OriginX + (X + 0.5f) * Header.CellSize, Header.OriginY + (Y + 0.5f) * Header.CellSize, Header.OriginZ + Height + EyeHeight);
+}
+
+int32 UTacticalGridSubsystem::RegionOf(int32 X, int32 Y) const
+{
+	const int32 RegionX = X * Header.RegionsX / Header.Width;
+	const int32 RegionY = Y * Header.RegionsY / Header.Height;
+	return RegionY * Header.RegionsX + RegionX;
+}
+
+bool UTacticalGridSubsystem::IsCoveredFrom(const FVector& Location, const FVector& Threat) const
+{
+	int32 X, Y;
+	if (!Cells || !WorldToCell(Location, X, Y))
+	{
+		return false;
+	}
+
+	//Which of the eight directions the threat is in
+	const FVector ToThreat = Threat - Location;
+	const float Angle = FMath::RadiansToDegrees(FMath::Atan2(ToThreat.Y, ToThreat.X));
+	const int32 Direction = (FMath::RoundToInt(Angle / 45.f) + 8) & 7;
+	return (Cells[Y * Header.Width + X].CoverMask & (1 << Direction)) != 0;
+}
+
+bool UTacticalGridSubsystem::CanSee(const FVector& From, const FVector& To) const
+{
+	int32 FromX, FromY, ToX, ToY;
+	if (!Cells || !WorldToCell(From, FromX, FromY) || !WorldToCell(To, ToX, ToY))
+	{
+		return false;
+	}
+	return (Cells[FromY * Header.Width + FromX].Visibility & (uint64(1) << RegionOf(ToX, ToY))) != 0;
+}
+
+bool UTacticalGridSubsystem::FindCoverNear(const FVector& Location, const FVector& Threat, int32 SearchCells, FVector& OutLocation) const
+{
+	int32 X, Y;
+	if (!Cells || !WorldToCell(Location, X, Y))
+	{
+		return false;
+	}
+
+	float BestDistSq = MAX_flt;
+	for (int32 CY = FMath::Max(Y - SearchCells, 0); CY <= FMath::Min(Y + SearchCells, Header.Height - 1); CY++)
+	{
+		for (int32 CX = FMath::Max(X - SearchCells, 0); CX <= FMath::Min(X + SearchCells, Header.Width - 1); CX++)
+		{
+			if (!(Cells[CY * Header.Width + CX].Flags & TacticalCell_Walkable))
+			{
+				continue;
+			}
+			const FVector Candidate = CellEye(CX, CY) - FVector(0.f, 0.f, EyeHeight);
+			const float DistSq = FVector::DistSquared2D(Candidate, Location);
+			if (DistSq < BestDistSq && IsCoveredFrom(Candidate, Threat))
+			{
+				BestDistSq = DistSq;
+				OutLocation = Candidate;
+			}
+		}
+	}
+	return BestDistSq < MAX_flt;
+}
+
+void UTacticalGridSubsystem::ProjectCell(int32 X, int32 Y, FTacticalCell& Cell) const
+{
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	const FVector Center(Header.OriginX + (X + 0.5f) * Header.CellSize, Header.OriginY + (Y + 0.5f) * Header.CellSize, Header.OriginZ);
+	const FVector Extent(Header.CellSize * 0.5f, Header.CellSize * 0.5f, 2000.f);
+	FNavLocation Projected;
+	if (NavSys && NavSys->ProjectPointToNavigation(Center, Projected, Extent))
+	{
+		Cell.Flags |= TacticalCell_Walkable;
+		Cell.Height = (int16)FMath::Clamp(FMath::RoundToInt(Projected.Location.Z - Header.OriginZ), -32768, 32767);
+	}
+	else
+	{
+		Cell.Flags &= ~TacticalCell_Walkable;
+		Cell.Height = 0;
+	}
+}
+
+uint8 UTacticalGridSubsystem::TraceCover(int32 X, int32 Y) const
+{
+	const FVector Eye = CellEye(X, Y);
+	FCollisionQueryParams Params(SCENE_QUERY_STAT(TacticalGridCover), false);
+	uint8 Mask = 0;
+	for (int32 d = 0; d < 8; d++)
+	{
+		if (GetWorld()->LineTraceTestByChannel(Eye, Eye + CoverDirections[d] * CoverDistance, WallChannel, Params))
+		{
+			Mask |= 1 << d;
+		}
+	}
+	return Mask;
+}
+
+bool UTacticalGridSubsystem::TraceVisibility(int32 X, int32 Y, int32 Region) const
+{
+	//Regions are seen through their centre cell
+	const int32 RegionX = Region % Header.RegionsX;
+	const int32 RegionY = Region / Header.RegionsX;
+	const int32 TargetX = FMath::Min((2 * RegionX + 1) * Header.Width / (2 * Header.RegionsX), Header.Width - 1);
+	const int32 TargetY = FMath::Min((2 * RegionY + 1) * Header.Height / (2 * Header.RegionsY), Header.Height - 1);
+	FCollisionQueryParams Params(SCENE_QUERY_STAT(TacticalGridVisibility), false);
+	return !GetWorld()->LineTraceTestByChannel(CellEye(X, Y), CellEye(TargetX, TargetY), WallChannel, Params);
+}
+
+void UTacticalGridSubsystem::BakeCell(int32 Index)
+{
+	FTacticalCell& Cell = GetWritableCell(Index);
+	const int32 X = Index % Header.Width;
+	const int32 Y = Index / Header.Width;
+	Cell.CoverMask = 0;
+	Cell.Visibility = 0;
+	if (!(Cell.Flags & TacticalCell_Walkable))
+	{
+		return;
+	}
+
+	Cell.CoverMask = TraceCover(X, Y);
+	for (int32 Region = 0; Region < Header.RegionsX * Header.RegionsY; Region++)
+	{
+		if (TraceVisibility(X, Y, Region))
+		{
+			Cell.Visibility |= uint64(1) << Region;
+		}
+	}
+}
+
+void UTacticalGridSubsystem::Bake()
+{
+	FBox Bounds(ForceInit);
+	for (TActorIterator<ANavMeshBoundsVolume> It(GetWorld()); It; ++It)
+	{
+		Bounds += It->GetComponentsBoundingBox(true);
+	}
+	if (!Bounds.IsValid)
+	{
+		UE_LOG(LogGameJam2, Warning, TEXT("No nav mesh bounds to bake a tactical grid over"));
+		return;
+	}
+
+	ReleaseGrid();
+	FMemory::Memzero(Header);
+	Header.Magic = TacticalGridMagic;
+	Header.Version = TacticalGridVersion;
+	Header.OriginX = Bounds.Min.X;
+	Header.OriginY = Bounds.Min.Y;
+	Header.OriginZ = Bounds.GetCenter().Z;
+	Header.CellSize = BakeCellSize;
+	Header.Width = FMath::Max(FMath::CeilToInt((Bounds.Max.X - Bounds.Min.X) / BakeCellSize), 1);
+	Header.Height = FMath::Max(FMath::CeilToInt((Bounds.Max.Y - Bounds.Min.Y) / BakeCellSize), 1);
+	Header.RegionsX = TacticalGridRegions;
+	Header.RegionsY = TacticalGridRegions;
+
+	const int32 NumCells = Header.Width * Header.Height;
+	OwnedCells.SetNumZeroed(NumCells);
+	Cells = OwnedCells.GetData();
+	DirtyCells.Reset();
+	DirtyRegions = 0;
+
+	//Nav mesh queries stay on this thread, the traces are spread over the workers a row at a time
+	const double StartTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < NumCells; i++)
+	{
+		ProjectCell(i % Header.Width, i / Header.Width, OwnedCells[i]);
+	}
+	ParallelFor(Header.Height, [this](int32 Y)
+	{
+		for (int32 X = 0; X < Header.Width; X++)
+		{
+			BakeCell(Y * Header.Width + X);
+		}
+	});
+
+	TArray<uint8> Bytes;
+	Bytes.Append(reinterpret_cast<const uint8*>(&Header), sizeof(FTacticalGridHeader));
+	Bytes.Append(reinterpret_cast<const uint8*>(OwnedCells.GetData()), NumCells * sizeof(FTacticalCell));
+	const FString Filename = GetGridFilename();
+	if (FFileHelper::SaveArrayToFile(Bytes, *Filename))
+	{
+		UE_LOG(LogGameJam2, Display, TEXT("Baked %dx%d tactical grid to %s in %.2fs"), Header.Width, Header.Height, *Filename, FPlatformTime::Seconds() - StartTime);
+	}
+	else
+	{
+		UE_LOG(LogGameJam2, Warning, TEXT("Could not write tactical grid %s"), *Filename);
+	}
+}
+
+void UTacticalGridSubsystem::InvalidateRegion(const FBox& Box)
+{
+	if (!Cells)
+	{
+		return;
+	}
+	MakeWritable();
+
+	//Cells near the change need everything re-baked
+	const FBox Expanded = Box.ExpandBy(CoverDistance + Header.CellSize);
+	int32 MinX, MinY, MaxX, MaxY;
+	WorldToCell(Expanded.Min, MinX, MinY);
+	WorldToCell(Expanded.Max, MaxX, MaxY);
+	MinX = FMath::Clamp(MinX, 0, Header.Width - 1);
+	MaxX = FMath::Clamp(MaxX, 0, Header.Width - 1);
+	MinY = FMath::Clamp(MinY, 0, Header.Height - 1);
+	MaxY = FMath::Clamp(MaxY, 0, Header.Height - 1);
+	for (int32 Y = MinY; Y <= MaxY; Y++)
+	{
+		for (int32 X = MinX; X <= MaxX; X++)
+		{
+			DirtyCells.Add(Y * Header.Width + X);
+		}
+	}
+
+	//Everyone else only needs their view of the regions the change is in
+	for (int32 Y = MinY; Y <= MaxY; Y++)
+	{
+		for (int32 X = MinX; X <= MaxX; X++)
+		{
+			DirtyRegions |= uint64(1) << RegionOf(X, Y);
+		}
+	}
+	RegionSweepCursor = 0;
+}
+
+void UTacticalGridSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TacticalRebake);
+
+	const int32 NumRegions = Header.RegionsX * Header.RegionsY;
+	int32 Traces = 0;
+	while (DirtyCells.Num() > 0 && Traces < MaxRebakeTracesPerFrame)
+	{
+		const int32 Index = DirtyCells.Pop(false);
+		ProjectCell(Index % Header.Width, Index / Header.Width, GetWritableCell(Index));
+		BakeCell(Index);
+		Traces += 8 + NumRegions;
+	}
+
+	const int32 NumCells = Header.Width * Header.Height;
+	while (DirtyCells.Num() == 0 && DirtyRegions != 0 && Traces < MaxRebakeTracesPerFrame)
+	{
+		FTacticalCell& Cell = GetWritableCell(RegionSweepCursor);
+		if (Cell.Flags & TacticalCell_Walkable)
+		{
+			const int32 X = RegionSweepCursor % Header.Width;
+			const int32 Y = RegionSweepCursor / Header.Width;
+			for (int32 Region = 0; Region < NumRegions; Region++)
+			{
+				const uint64 Bit = uint64(1) << Region;
+				if (DirtyRegions & Bit)
+				{
+					Cell.Visibility = TraceVisibility(X, Y, Region) ? (Cell.Visibility | Bit) : (Cell.Visibility & ~Bit);
+					Traces++;
+				}
+			}
+		}
+		if (++RegionSweepCursor >= NumCells)
+		{
+			RegionSweepCursor = 0;
+			DirtyRegions = 0;
+		}
+	}
+
+	SET_DWORD_STAT(STAT_TacticalRebakeTraces, Traces);
+	SET_DWORD_STAT(STAT_TacticalDirtyCells, DirtyCells.Num());
+}
@@ -0,0 +1,149 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TacticalGridSubsystem.generated.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+//On disk layout of a baked grid: the header followed by Width * Height cells, row by row
+struct FTacticalGridHeader
+{
+	uint32 Magic;
+	uint32 Version;
+	float OriginX;
+	float OriginY;
+	float OriginZ;
+	float CellSize;
+	int32 Width;
+	int32 Height;
+	int32 RegionsX;
+	int32 RegionsY;
+	uint32 Padding[2];
+};
+
+struct FTacticalCell
+{
+	//TacticalCell_ flags
+	uint8 Flags;
+	//Bit d set when a wall is close in direction d (0 is +X, counting 45 degrees towards +Y)
+	uint8 CoverMask;
+	//Nav mesh height of the cell above OriginZ
+	int16 Height;
+	uint8 Padding[4];
+	//Bit r set when region r can be seen from this cell
+	uint64 Visibility;
+};
+
+enum ETacticalCellFlags : uint8
+{
+	TacticalCell_Walkable = 1 << 0,
+};
+
+/**
+ * A baked grid over the nav mesh with cover directions and coarse visibility for every cell, so AI can ask
+ * "is this spot covered from there" or "can this spot see that one" with a table lookup instead of traces.
+ * Visibility is between a cell and an 8x8 grid of regions covering the level, one bit per region.
+ * The grid is baked with GameJam2.BakeTacticalGrid into a binary file per map and memory mapped at runtime.
+ * InvalidateRegion re-bakes the affected cells a few per frame. Room streaming calls it as rooms load and unload.
+ */
+UCLASS(config = Game)
+class GAMEJAM2_API UTacticalGridSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End FTickableGameObject interface
+
+	bool IsLoaded() const { return Cells != nullptr; }
+
+	//True if Location has a wall between it and Threat close by
+	bool IsCoveredFrom(const FVector& Location, const FVector& Threat) const;
+
+	//Coarse line of sight, true if From's cell can see the region To is in
+	bool CanSee(const FVector& From, const FVector& To) const;
+
+	//Closest walkable cell within SearchCells of Location that is covered from Threat
+	bool FindCoverNear(const FVector& Location, const FVector& Threat, int32 SearchCells, FVector& OutLocation) const;
+
+	//Bake the whole grid for this world and write it to the map's grid file
+	void Bake();
+
+	//Re-bake every cell in and around the box, and every cell's visibility towards it
+	void InvalidateRegion(const FBox& Box);
+
+	//Grid cell size used when baking
+	UPROPERTY(Config)
+	float BakeCellSize = 200.f;
+
+	//How close a wall has to be to count as cover
+	UPROPERTY(Config)
+	float CoverDistance = 150.f;
+
+	//Height above the nav mesh the cover and visibility traces run at
+	UPROPERTY(Config)
+	float EyeHeight = 60.f;
+
+	//Channel walls block
+	UPROPERTY(Config)
+	TEnumAsByte<ECollisionChannel> WallChannel = ECC_WorldStatic;
+
+	//Line traces allowed per frame while re-baking at runtime
+	UPROPERTY(Config)
+	int32 MaxRebakeTracesPerFrame = 256;
+
+private:
+	FString GetGridFilename() const;
+
+	bool LoadGrid();
+
+	void ReleaseGrid();
+
+	//Copy a mapped grid into memory we own so it can be changed
+	void MakeWritable();
+
+	bool WorldToCell(const FVector& Location, int32& OutX, int32& OutY) const;
+
+	FVector CellEye(int32 X, int32 Y) const;
+
+	int32 RegionOf(int32 X, int32 Y) const;
+
+	//Walkable flag and height for a cell from the nav mesh
+	void ProjectCell(int32 X, int32 Y, FTacticalCell& Cell) const;
+
+	uint8 TraceCover(int32 X, int32 Y) const;
+
+	bool TraceVisibility(int32 X, int32 Y, int32 Region) const;
+
+	void BakeCell(int32 Index);
+
+	FTacticalCell& GetWritableCell(int32 Index) { return OwnedCells[Index]; }
+
+	FTacticalGridHeader Header;
+
+	//Points into the mapped file or OwnedCells
+	const FTacticalCell* Cells = nullptr;
+
+	IMappedFileHandle* MappedHandle = nullptr;
+	IMappedFileRegion* MappedRegion = nullptr;
+
+	TArray<FTacticalCell> OwnedCells;
+
+	//Runtime re-bake: cells to bake in full, then a sweep over all cells for the regions in DirtyRegions
+	TArray<int32> DirtyCells;
+	uint64 DirtyRegions = 0;
+	int32 RegionSweepCursor = 0;
+};
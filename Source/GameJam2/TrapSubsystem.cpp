@@ -0,0 +1,160 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TrapSubsystem.h"
+#include "GameJam2.h"
+#include "InvisibleTrap.h"
+#include "Kismet/GameplayStatics.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Trap Overlaps"), STAT_TrapOverlaps, STATGROUP_GameJam2);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Registered Traps"), STAT_RegisteredTraps, STATGROUP_GameJam2);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Traps Triggered"), STAT_TrapsTriggered, STATGROUP_GameJam2);
+
+bool UTrapSubsystem::IsTickable() const
+{
+	return NumTraps > 0;
+}
+
+ETickableTickType UTrapSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId UTrapSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTrapSubsystem, STATGROUP_Tickables);
+}
+
+FIntPoint UTrapSubsystem::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
+
+void UTrapSubsystem::RegisterTrap(AInvisibleTrap* Trap)
+{
+	if (!Trap)
+	{
+		return;
+	}
+
+	const int32 Index = FreeTraps.Num() > 0 ? FreeTraps.Pop(false) : Traps.AddDefaulted();
+	FTrapEntry& Entry = Traps[Index];
+	Entry.Trap = Trap;
+	Entry.Bounds = Trap->GetTriggerBounds();
+	Entry.bPlayerInside = false;
+
+	//Traps don't move, so they are put in the grid once
+	const FIntPoint Min = GetCell(Entry.Bounds.Min);
+	const FIntPoint Max = GetCell(Entry.Bounds.Max);
+	for (int32 Y = Min.Y; Y <= Max.Y; Y++)
+	{
+		for (int32 X = Min.X; X <= Max.X; X++)
+		{
+			Cells.FindOrAdd(FIntPoint(X, Y)).Add(Index);
+		}
+	}
+	NumTraps++;
+	INC_DWORD_STAT(STAT_RegisteredTraps);
+}
+
+void UTrapSubsystem::UnregisterTrap(AInvisibleTrap* Trap)
+{
+	const int32 Index = Traps.IndexOfByPredicate([Trap](const FTrapEntry& Entry) { return Entry.Trap == Trap; });
+	if (Index == INDEX_NONE)
+	{
+		return;
+	}
+
+	const FBox& Bounds = Traps[Index].Bounds;
+	const FIntPoint Min = GetCell(Bounds.Min);
+	const FIntPoint Max = GetCell(Bounds.Max);
+	for (int32 Y = Min.Y; Y <= Max.Y; Y++)
+	{
+		for (int32 X = Min.X; X <= Max.X; X++)
+		{
+			if (TArray<int32>* Cell = Cells.Find(FIntPoint(X, Y)))
+			{
+				Cell->RemoveSwap(Index);
+				if (Cell->Num() == 0)
+				{
+					Cells.Remove(FIntPoint(X, Y));
+				}
+			}
+		}
+	}
+
+	Traps[Index] = FTrapEntry();
+	Occupied.RemoveSwap(Index);
+	FreeTraps.Add(Index);
+	NumTraps--;
+	DEC_DWORD_STAT(STAT_RegisteredTraps);
+}
+
+void UTrapSubsystem::Tick(float DeltaTime)
+{
+	APawn* Player = UGameplayStatics::GetPlayerPawn(this, 0);
+	if (!Player)
+	{
+		return;
+	}
+
+	//Traps don't move, so nothing can have changed while the player hasn't
+	const FVector Location = Player->GetActorLocation();
+	if (Location.Equals(LastPlayerLocation))
+	{
+		return;
+	}
+	LastPlayerLocation = Location;
+
+	SCOPE_CYCLE_COUNTER(STAT_TrapOverlaps);
+
+	float Radius, HalfHeight;
+	Player->GetSimpleCollisionCylinder(Radius, HalfHeight);
+	const FVector Extent(Radius, Radius, HalfHeight);
+	const FBox PlayerBox(Location - Extent, Location + Extent);
+
+	Candidates.Reset();
+	const FIntPoint Min = GetCell(PlayerBox.Min);
+	const FIntPoint Max = GetCell(PlayerBox.Max);
+	for (int32 Y = Min.Y; Y <= Max.Y; Y++)
+	{
+		for (int32 X = Min.X; X <= Max.X; X++)
+		{
+			if (const TArray<int32>* Cell = Cells.Find(FIntPoint(X, Y)))
+			{
+				for (int32 Index : *Cell)
+				{
+					Candidates.AddUnique(Index);
+				}
+			}
+		}
+	}
+
+	//Left traps can be set off again next time, like an actor overlap ending
+	for (int32 i = Occupied.Num() - 1; i >= 0; i--)
+	{
+		FTrapEntry& Entry = Traps[Occupied[i]];
+		if (!Entry.Bounds.Intersect(PlayerBox))
+		{
+			Entry.bPlayerInside = false;
+			Occupied.RemoveAtSwap(i, 1, false);
+		}
+	}
+
+	for (int32 Index : Candidates)
+	{
+		FTrapEntry& Entry = Traps[Index];
+		if (Entry.bPlayerInside || !Entry.Bounds.Intersect(PlayerBox))
+		{
+			continue;
+		}
+		Entry.bPlayerInside = true;
+		Occupied.Add(Index);
+		if (AInvisibleTrap* Trap = Entry.Trap.Get())
+		{
+			INC_DWORD_STAT(STAT_TrapsTriggered);
+			Trap->OnPlayerEnter(Player);
+		}
+	}
+}
@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TrapSubsystem.generated.h"
+
+class AInvisibleTrap;
+
+//A registered trap and the box that sets it off
+struct FTrapEntry
+{
+	TWeakObjectPtr<AInvisibleTrap> Trap;
+	FBox Bounds;
+	bool bPlayerInside = false;
+};
+
+/**
+ * Owns every trap in the world. Traps don't tick or generate overlap events, instead their trigger boxes sit in
+ * one 2D grid and only the cells around the player are checked, and only on frames the player has moved.
+ * The cost doesn't grow with the number of traps, and is nothing while the player stands still.
+ */
+UCLASS(config = Game)
+class GAMEJAM2_API UTrapSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End FTickableGameObject interface
+
+	void RegisterTrap(AInvisibleTrap* Trap);
+	void UnregisterTrap(AInvisibleTrap* Trap);
+
+	int32 GetNumTraps() const { return NumTraps; }
+
+	//Size of a grid cell, traps bigger than a cell are listed in every cell they touch
+	UPROPERTY(Config)
+	float CellSize = 500.f;
+
+private:
+	FIntPoint GetCell(const FVector& Location) const;
+
+	TArray<FTrapEntry> Traps;
+	TArray<int32> FreeTraps;
+	int32 NumTraps = 0;
+
+	//Traps touching each cell, by index into Traps
+	TMap<FIntPoint, TArray<int32>> Cells;
+
+	//Traps the player was inside last check
+	TArray<int32> Occupied;
+
+	FVector LastPlayerLocation = FVector(MAX_flt);
+
+	//Per check scratch
+	TArray<int32> Candidates;
+};
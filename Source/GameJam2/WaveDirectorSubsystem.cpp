@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "WaveDirectorSubsystem.h"
+#include "GameJam2.h"
+#include "EnemySpawner.h"
+#include "TimerManager.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Wave Director"), STAT_WaveDirector, STATGROUP_GameJam2);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Wave Queued Spawns"), STAT_WaveQueued, STATGROUP_GameJam2);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Wave Spawns"), STAT_WaveSpawns, STATGROUP_GameJam2);
+
+void UWaveDirectorSubsystem::StartSchedule(AEnemySpawner* Spawner)
+{
+	if (!Spawner)
+	{
+		return;
+	}
+
+	const float Now = GetWorld()->GetTimeSeconds();
+	const TArray<FEnemySpawnEntry>& Schedule = Spawner->GetSpawnSchedule();
+	for (int32 i = 0; i < Schedule.Num(); i++)
+	{
+		if (!Schedule[i].EnemyClass.IsNull())
+		{
+			Events.HeapPush({ Now + Schedule[i].InitialDelay, Spawner, i, Schedule[i].RepeatCount });
+		}
+	}
+	SET_DWORD_STAT(STAT_WaveQueued, Events.Num());
+	ArmTimer();
+}
+
+void UWaveDirectorSubsystem::StopSchedule(AEnemySpawner* Spawner)
+{
+	if (Events.RemoveAll([Spawner](const FWaveSpawnEvent& Event) { return Event.Spawner == Spawner; }) > 0)
+	{
+		Events.Heapify();
+		SET_DWORD_STAT(STAT_WaveQueued, Events.Num());
+		ArmTimer();
+	}
+}
+
+void UWaveDirectorSubsystem::ArmTimer()
+{
+	FTimerManager& TimerManager = GetWorld()->GetTimerManager();
+	if (Events.Num() == 0)
+	{
+		TimerManager.ClearTimer(SpawnTimerHandle);
+		return;
+	}
+
+	//Only ever one timer, for whichever spawn is next
+	const float Delay = Events.HeapTop().Time - GetWorld()->GetTimeSeconds();
+	TimerManager.SetTimer(SpawnTimerHandle, this, &UWaveDirectorSubsystem::OnSpawnTimer, FMath::Max(Delay, KINDA_SMALL_NUMBER), false);
+}
+
+void UWaveDirectorSubsystem::OnSpawnTimer()
+{
+	SCOPE_CYCLE_COUNTER(STAT_WaveDirector);
+
+	const float Now = GetWorld()->GetTimeSeconds();
+	while (Events.Num() > 0 && Events.HeapTop().Time <= Now + KINDA_SMALL_NUMBER)
+	{
+		FWaveSpawnEvent Event;
+		Events.HeapPop(Event, false);
+
+		AEnemySpawner* Spawner = Event.Spawner.Get();
+		if (!Spawner)
+		{
+			continue;
+		}
+		const FEnemySpawnEntry& Entry = Spawner->GetSpawnSchedule()[Event.EntryIndex];
+		Spawner->SpawnEntry(Entry);
+		INC_DWORD_STAT(STAT_WaveSpawns);
+
+		//Repeats are timed from when this spawn was due, so a late frame doesn't push the whole wave back
+		if (Event.RepeatsLeft > 0)
+		{
+			Events.HeapPush({ Event.Time + FMath::Max(Entry.RepeatInterval, 0.f), Event.Spawner, Event.EntryIndex, Event.RepeatsLeft - 1 });
+		}
+	}
+
+	SET_DWORD_STAT(STAT_WaveQueued, Events.Num());
+	ArmTimer();
+}
@@ -0,0 +1,49 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "WaveDirectorSubsystem.generated.h"
+
+class AEnemySpawner;
+
+//A spawn due at Time, from one entry of a spawner's schedule
+struct FWaveSpawnEvent
+{
+	float Time;
+	TWeakObjectPtr<AEnemySpawner> Spawner;
+	int32 EntryIndex;
+	int32 RepeatsLeft;
+
+	bool operator<(const FWaveSpawnEvent& Other) const { return Time < Other.Time; }
+};
+
+/**
+ * Runs every spawner's schedule from one priority queue of upcoming spawns.
+ * A single timer is armed for the earliest event, so nothing runs between spawns and idle rooms cost nothing.
+ */
+UCLASS()
+class GAMEJAM2_API UWaveDirectorSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	//Queue the first spawn of every entry in the spawner's schedule
+	void StartSchedule(AEnemySpawner* Spawner);
+
+	//Drop everything still queued for the spawner
+	void StopSchedule(AEnemySpawner* Spawner);
+
+	int32 GetNumQueued() const { return Events.Num(); }
+
+private:
+	void OnSpawnTimer();
+
+	void ArmTimer();
+
+	//Min heap on Time
+	TArray<FWaveSpawnEvent> Events;
+
+	FTimerHandle SpawnTimerHandle;
+};
@@ -0,0 +1,103 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataTable.h"
+#include "WeaponDefinition.generated.h"
+
+//How the pellets of a multi pellet weapon are spread around the muzzle direction
+UENUM(BlueprintType)
+enum class EWeaponSpreadPattern : uint8
+{
+	//Pellets evenly spaced across SpreadAngle
+	Fan,
+	//Pellets use the yaw offsets in PelletAngles, repeated if there are more pellets than angles
+	AngleTable,
+	//Pellets randomly placed in a SpreadAngle cone, seeded per shot so volleys are repeatable
+	SeededCone
+};
+
+/**
+ * Static description of a weapon, one row per weapon in the weapon table.
+ * The row index is the weapon id used by CurrentWeapon.
+ */
+USTRUCT(BlueprintType)
+struct FWeaponDefinition : public FTableRowBase
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weapon)
+	FName WeaponName;
+
+	//Bullet spawned per shot, the character keeps its current bullet when empty
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weapon)
+	TSubclassOf<AActor> ProjectileClass;
+
+	//Sounds, the character keeps its current sounds when these are empty
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weapon)
+	class USoundBase* ShootSound = nullptr;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weapon)
+	class USoundBase* ReloadSound = nullptr;
+
+	//Firing mode (0 - Single fire, 1 - Automatic)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weapon)
+	int FiringMode = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weapon)
+	int MaxAmmo = 50;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weapon)
+	int ClipSize = 10;
+
+	//Seconds between shots
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weapon)
+	float ShootSpeed = 0.3f;
+
+	//Seconds to reload
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weapon)
+	float ReloadSpeed = 2.f;
+
+	//Bullets fired per shot, all from the one muzzle transform
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weapon)
+	int PelletCount = 1;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weapon)
+	EWeaponSpreadPattern SpreadPattern = EWeaponSpreadPattern::Fan;
+
+	//Total spread in degrees for Fan and SeededCone
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weapon)
+	float SpreadAngle = 0.f;
+
+	//Yaw offsets in degrees for AngleTable
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weapon)
+	TArray<float> PelletAngles;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weapon)
+	int SpreadSeed = 0;
+
+	//Resolve shots as batched hitscan traces instead of spawning bullets
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weapon)
+	bool bHitscan = false;
+
+	//Simulate bullets as data in the projectile simulation instead of spawning actors
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weapon)
+	bool bSimulateProjectiles = false;
+};
+
+//Per weapon ammo the player is carrying, indexed by weapon id
+USTRUCT(BlueprintType)
+struct FWeaponState
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weapon)
+	int Ammo = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weapon)
+	int AmmoInClip = 0;
+
+	//World time the next shot is due, advanced by ShootSpeed per shot so fire rate doesn't depend on framerate
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Weapon)
+	float NextShotTime = 0.f;
+};